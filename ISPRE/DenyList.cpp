@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//  Realized speculation counts and the deny list built from them
+//
+//  The counts file of an -ispre-instrument build tells how often every speculated value was
+//  used (saved) against how often it was computed on an ingress edge (added). ispre-denylist
+//  keeps the expressions whose use ratio saved / added fell below a threshold in a deny list
+//  that grows over successive builds, and -ispre-deny-list=<file> makes the ISPRE passes
+//  leave those expressions alone.
+//
+////===----------------------------------------------------------------------===//
+#include "DenyList.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/WithColor.h"
+
+using namespace llvm;
+
+bool readSpeculationCounts(StringRef path, SpeculationCounts &counts) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(path);
+    if (!buffer) {
+        WithColor::error() << path << ": " << buffer.getError().message() << "\n";
+        return false;
+    }
+    // The first line is the header and a counts file ends with a total line
+    SmallVector<StringRef, 0> lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, false);
+    for (size_t i = 1; i < lines.size(); i++) {
+        SmallVector<StringRef, 6> fields;
+        lines[i].split(fields, '\t');
+        uint64_t saved, added;
+        if (fields.size() < 5 || fields[3].getAsInteger(10, saved) ||
+            fields[4].getAsInteger(10, added)) {
+            WithColor::warning() << path << ":" << i + 1 << ": malformed line\n";
+            continue;
+        }
+        if (fields[0] == "total" && fields[1] == "-") {
+            continue;
+        }
+        SpeculationCount &count = counts[{fields[0].str(), fields[1].str()}];
+        count.expression = fields[2].str();
+        count.saved += saved;
+        count.added += added;
+    }
+    return true;
+}
+
+namespace {
+// Deny lists read so far; every ISPRE pass of a pipeline reads the same one
+std::map<std::string, SpeculationCounts> LoadedDenyLists;
+} // namespace
+
+const SpeculationCount *findDeniedSpeculation(StringRef path, StringRef function,
+                                              StringRef site) {
+    auto loaded = LoadedDenyLists.find(path.str());
+    if (loaded == LoadedDenyLists.end()) {
+        loaded = LoadedDenyLists.emplace(path.str(), SpeculationCounts()).first;
+        readSpeculationCounts(path, loaded->second);
+    }
+    auto entry = loaded->second.find({function.str(), site.str()});
+    return entry == loaded->second.end() ? nullptr : &entry->second;
+}
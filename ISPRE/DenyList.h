@@ -0,0 +1,38 @@
+//===----------------------------------------------------------------------===//
+//
+//  Realized speculation counts and the deny list built from them
+//
+////===----------------------------------------------------------------------===//
+#ifndef ISPRE_DENYLIST_H
+#define ISPRE_DENYLIST_H
+
+#include "llvm/ADT/StringRef.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+
+// Executions of one speculated expression, as counted by -ispre-instrument
+struct SpeculationCount {
+    std::string expression;
+    uint64_t saved = 0;
+    uint64_t added = 0;
+};
+
+// Keyed by function and site. The site names the pass, the block and the index of the
+// expression among the binary operators of the block, as in "ispre2:for.body:3", so that it
+// survives the renumbering of unnamed values between builds.
+using SpeculationCounts = std::map<std::pair<std::string, std::string>, SpeculationCount>;
+
+// Read the lines of a counts file written by runtime/ispre_rt.c, or of a deny list, which has
+// the same first five columns (function, site, expression, saved, added). Counts of the same
+// site are summed. False if the file cannot be read.
+bool readSpeculationCounts(llvm::StringRef path, SpeculationCounts &counts);
+
+// The deny list entry of the expression of function at site, or null if it is not in the deny
+// list at path
+const SpeculationCount *findDeniedSpeculation(llvm::StringRef path, llvm::StringRef function,
+                                              llvm::StringRef site);
+
+#endif // ISPRE_DENYLIST_H
@@ -2,20 +2,45 @@
 //
 //  ISPRE Pass
 //
+//  The passes of the multipass cascade (-ispre, -ispre2, -ispre3 and -ispre4) are one
+//  implementation that differs only in the name it reports under and its default threshold.
+//
 ////===----------------------------------------------------------------------===//
+#include "llvm/ADT/Statistic.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Analysis/BlockFrequencyInfo.h"
 #include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/Analysis/ProfileSummaryInfo.h"
 #include "llvm/IR/CFG.h"
 #include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/InstIterator.h"
 #include "llvm/IR/Instructions.h"
 #include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/ModuleSlotTracker.h"
+#include "llvm/IR/PassTimingInfo.h"
 #include "llvm/Support/Debug.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/TimeProfiler.h"
+#include "llvm/Support/Timer.h"
+#include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
 #include "llvm/Transforms/Utils/ValueMapper.h"
 
+#include "DenyList.h"
+#include "ISPREOptions.h"
+#include "PathProfile.h"
+#include "PhaseObserver.h"
+
 #include <algorithm>
+#include <limits>
 #include <map>
 #include <set>
 #include <string>
@@ -27,11 +52,83 @@ using namespace llvm;
 
 #define DEBUG_TYPE "ispre"
 
+STATISTIC(NumCandidates, "Number of candidate expressions in hot regions");
+STATISTIC(NumIngressEdges, "Number of ingress edges");
+STATISTIC(NumInserts, "Number of expressions inserted on ingress edges");
+STATISTIC(NumRemovals, "Number of expressions replaced by a load of the speculated value");
+STATISTIC(NumAllocas, "Number of allocas created to hold speculated values");
+STATISTIC(NumAvailIterations, "Number of iterations of the availability dataflow");
+STATISTIC(NumNeedIterations, "Number of iterations of the need dataflow");
+STATISTIC(NumNoProfile, "Number of functions skipped for lack of a profile");
+STATISTIC(NumStaticFunctions, "Number of functions classified by static frequency estimates");
+STATISTIC(NumStaticCapped, "Number of functions left unchanged by the static speculation cap");
+STATISTIC(NumContextSensitive, "Number of functions classified by a context-sensitive profile");
+STATISTIC(NumPathRegions, "Number of functions whose hot region was built from hot paths");
+STATISTIC(NumColdFunctions, "Number of functions skipped as cold in the module profile");
+STATISTIC(NumColdFunctionBlocks, "Number of blocks in functions skipped as cold");
+STATISTIC(NumModuleCold, "Number of blocks and edges hot in their function but not in the module");
+STATISTIC(NumLoopHot, "Number of blocks hot relative to their loop header but not to the function");
+STATISTIC(NumDenied, "Number of removable expressions skipped by the deny list");
+STATISTIC(NumBands, "Number of temperature band boundaries solved");
+STATISTIC(NumWorkloadCold, "Number of blocks and edges hot in the profile but not under the "
+                           "workload quorum");
+
 namespace ISPRE {
+// Times one phase of a pass: reported under -time-passes and as a -ftime-trace scope
+struct PhaseScope {
+    NamedRegionTimer Timer;
+    TimeTraceScope Trace;
+    StringRef Pass;
+    StringRef Name;
+    PhaseScope(StringRef pass, StringRef name, StringRef description)
+        : Timer(name, description, pass, ("ISPRE Phases (" + pass + ")").str(),
+                TimePassesIsEnabled),
+          Trace(name), Pass(pass), Name(name) {
+        if (PhaseObserver) {
+            PhaseObserver(Pass, Name, true);
+        }
+    }
+    ~PhaseScope() {
+        if (PhaseObserver) {
+            PhaseObserver(Pass, Name, false);
+        }
+    }
+};
+
+// Default threshold of the first stage, -ispre. -ispre-adaptive-threshold picks the cut-off of
+// that stage, and every stage scales it by its own threshold relative to this one.
+constexpr double FIRST_STAGE_THRESHOLD = 0.9;
+
 struct ISPREPass : public FunctionPass {
-    static char ID;
-    static constexpr double THRESHOLD = 0.9;
-    ISPREPass() : FunctionPass(ID) {}
+    // Registered name of the pass, which its remarks, timers, dumps and sites are named after
+    const char *passName;
+    // The -<pass>-threshold option: blocks and edges whose count is above this fraction of the
+    // hottest block are hot
+    cl::opt<double> &Threshold;
+    // The function being optimized has no profile and is classified by static estimates
+    bool usesStaticEstimates = false;
+    // The counts come from a context-sensitive (CSPGO) profile: blocks inlined from a callee
+    // carry the counts of their own call site
+    bool usesContextSensitiveProfile = false;
+    // The hot region is the union of the hot paths of a -ispre-path-profile
+    bool usesPathProfile = false;
+    std::set<StringRef> pathHotNodes;
+    std::set<std::pair<StringRef, StringRef>> pathHotEdges;
+    // Cut-off of the function being optimized: Threshold, the one picked from its count
+    // distribution by -ispre-adaptive-threshold and scaled to this stage, or the -ispre-bands
+    // boundary being solved
+    double threshold = FIRST_STAGE_THRESHOLD;
+    // 1-based index of the -ispre-bands boundary being solved, 0 without bands
+    unsigned band = 0;
+    // Profile summary of the module, when the function's counts come from a profile
+    ProfileSummaryInfo *psi = nullptr;
+    // Every instruction of the function as printed before the pass changed it, so that the
+    // remarks, dumps and counters number values like the input IR does
+    std::map<Instruction *, std::string> exprStrings;
+    // Site of every binary operator of the function before the pass changed it
+    std::map<Instruction *, std::string> siteNames;
+    ISPREPass(char &ID, const char *passName, cl::opt<double> &threshold)
+        : FunctionPass(ID), passName(passName), Threshold(threshold) {}
 
     void printEdges(std::vector<std::pair<StringRef, StringRef>> edges, const char *currEdges) {
         errs() << "*************\n" << currEdges << "\n*************\n";
@@ -124,22 +221,410 @@ struct ISPREPass : public FunctionPass {
         printMap_Edge_Set(inserts, "inserts");
     }
 
-    int calculateHotColdNodes(Function &F, std::map<StringRef, double> &freqs,
-                              std::vector<StringRef> &hotNodes, std::vector<StringRef> &coldNodes) {
+    std::unique_ptr<raw_fd_ostream> openDumpFile(StringRef dir, Function &F, StringRef ext) {
+        SmallString<128> path(dir);
+        std::string name = (F.getName() + "." + passName).str();
+        if (band) {
+            name += ".band" + std::to_string(band);
+        }
+        sys::path::append(path, name + "." + ext);
+        std::error_code EC;
+        auto os = std::make_unique<raw_fd_ostream>(path, EC, sys::fs::OF_Text);
+        if (EC) {
+            WithColor::warning() << "could not open " << path << ": " << EC.message() << '\n';
+            return nullptr;
+        }
+        return os;
+    }
+
+    json::Array exprArray(const std::set<Instruction *> &exprs) {
+        json::Array array;
+        for (Instruction *expr : exprs) {
+            array.push_back(exprString(expr));
+        }
+        return array;
+    }
+
+    // JSON integers are signed; counts saturated by BFI are written as INT64_MAX
+    static int64_t jsonCount(uint64_t count) {
+        return (int64_t)std::min<uint64_t>(count, std::numeric_limits<int64_t>::max());
+    }
+
+    // Write every input and result of the pass for F as one JSON object, before the IR changes
+    void dumpJSON(Function &F, uint64_t maxCount, std::map<StringRef, double> &freqs,
+                  std::vector<StringRef> &hotNodes,
+                  std::vector<std::pair<StringRef, StringRef>> &hotEdges,
+                  std::vector<std::pair<StringRef, StringRef>> &ingressEdges,
+                  std::map<StringRef, std::set<Instruction *>> &xUses,
+                  std::map<StringRef, std::set<Instruction *>> &gens,
+                  std::map<StringRef, std::set<Instruction *>> &kills,
+                  std::set<Instruction *> &candidates,
+                  std::map<StringRef, std::set<Instruction *>> &avins,
+                  std::map<StringRef, std::set<Instruction *>> &avouts,
+                  std::map<StringRef, std::set<Instruction *>> &removables,
+                  std::map<StringRef, std::set<Instruction *>> &needins,
+                  std::map<StringRef, std::set<Instruction *>> &needouts,
+                  std::map<std::pair<StringRef, StringRef>, std::set<Instruction *>> &inserts) {
+        std::unique_ptr<raw_fd_ostream> os = openDumpFile(DumpJSONDir, F, "json");
+        if (!os) {
+            return;
+        }
+
+        json::OStream J(*os, 2);
+        J.object([&] {
+            J.attribute("function", F.getName());
+            J.attribute("pass", passName);
+            J.attribute("threshold", threshold);
+            J.attribute("band", (int64_t)band);
+            J.attribute("maxCount", jsonCount(maxCount));
+            J.attribute("staticEstimates", usesStaticEstimates);
+            J.attribute("contextSensitive", usesContextSensitiveProfile);
+            J.attribute("pathProfile", usesPathProfile);
+            J.attribute("loopRelative", LoopRelative.getValue());
+            J.attributeArray("blocks", [&] {
+                for (BasicBlock &BB : F) {
+                    StringRef name = BB.getName();
+                    J.object([&] {
+                        J.attribute("name", name);
+                        J.attribute("count", jsonCount(getBlockCount(&BB)));
+                        J.attribute("relativeCount", freqs[name]);
+                        J.attribute("hot", (bool)std::count(hotNodes.begin(), hotNodes.end(),
+                                                            name));
+                        J.attribute("xUses", exprArray(xUses[name]));
+                        J.attribute("gens", exprArray(gens[name]));
+                        J.attribute("kills", exprArray(kills[name]));
+                        J.attribute("avin", exprArray(avins[name]));
+                        J.attribute("avout", exprArray(avouts[name]));
+                        J.attribute("removable", exprArray(removables[name]));
+                        J.attribute("needin", exprArray(needins[name]));
+                        J.attribute("needout", exprArray(needouts[name]));
+                    });
+                }
+            });
+            J.attributeArray("edges", [&] {
+                for (BasicBlock &BB : F) {
+                    for (BasicBlock *successor : successors(&BB)) {
+                        std::pair<StringRef, StringRef> edge =
+                            std::make_pair(BB.getName(), successor->getName());
+                        J.object([&] {
+                            J.attribute("from", edge.first);
+                            J.attribute("to", edge.second);
+                            J.attribute("count", jsonCount(getEdgeCount(&BB, successor)));
+                            J.attribute("hot", (bool)std::count(hotEdges.begin(), hotEdges.end(),
+                                                                edge));
+                            J.attribute("ingress", (bool)std::count(ingressEdges.begin(),
+                                                                    ingressEdges.end(), edge));
+                        });
+                    }
+                }
+            });
+            J.attribute("candidates", exprArray(candidates));
+            J.attributeArray("inserts", [&] {
+                for (auto &pair : inserts) {
+                    J.object([&] {
+                        J.attribute("from", pair.first.first);
+                        J.attribute("to", pair.first.second);
+                        J.attribute("expressions", exprArray(pair.second));
+                    });
+                }
+            });
+        });
+        *os << '\n';
+    }
+
+    static std::string dotEscape(StringRef str) {
+        std::string escaped;
+        for (char c : str) {
+            if (c == '"' || c == '\\') {
+                escaped += '\\';
+            }
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // Write the CFG of F as DOT: blocks are colored from blue (cold) to red (hot) by their
+    // relative count, ingress edges are highlighted and labeled with the inserted expressions,
+    // and blocks list the expressions that will be replaced by the speculated value
+    void dumpDot(Function &F, std::map<StringRef, double> &freqs, std::vector<StringRef> &hotNodes,
+                 std::vector<std::pair<StringRef, StringRef>> &hotEdges,
+                 std::vector<std::pair<StringRef, StringRef>> &ingressEdges,
+                 std::map<std::pair<StringRef, StringRef>, std::set<Instruction *>> &inserts) {
+        std::unique_ptr<raw_fd_ostream> os = openDumpFile(DumpDotDir, F, "dot");
+        if (!os) {
+            return;
+        }
+
+        std::set<Instruction *> removed;
+        for (auto &pair : inserts) {
+            removed.insert(pair.second.begin(), pair.second.end());
+        }
+
+        std::string title;
+        raw_string_ostream(title) << F.getName() << " (" << passName << ", threshold "
+                                  << format("%.2f", threshold) << ")";
+        *os << "digraph \"" << dotEscape(title) << "\" {\n";
+        *os << "    label=\"" << dotEscape(title) << "\";\n";
+        *os << "    node [shape=box, style=filled, fontname=\"Courier\"];\n";
+        for (BasicBlock &BB : F) {
+            StringRef name = BB.getName();
+            bool isHot = std::count(hotNodes.begin(), hotNodes.end(), name);
+            std::string label = (name + "\\ncount " + Twine(getBlockCount(&BB)) +
+                                 (isHot ? " (hot)" : " (cold)") + "\\l")
+                                    .str();
+            for (Instruction &instr : BB) {
+                if (removed.count(&instr)) {
+                    label += "removed: " + dotEscape(exprString(&instr)) + "\\l";
+                }
+            }
+            // Hue 0.66 is blue and 0 is red
+            *os << "    \"" << dotEscape(name) << "\" [label=\"" << label << "\", fillcolor=\""
+                << format("%.3f 0.500 1.000", 0.66 * (1.0 - freqs[name])) << "\""
+                << (isHot ? ", penwidth=2" : "") << "];\n";
+        }
+        for (BasicBlock &BB : F) {
+            for (BasicBlock *successor : successors(&BB)) {
+                std::pair<StringRef, StringRef> edge =
+                    std::make_pair(BB.getName(), successor->getName());
+                std::string label = std::to_string(getEdgeCount(&BB, successor));
+                std::string style;
+                if (std::count(ingressEdges.begin(), ingressEdges.end(), edge)) {
+                    label += " (ingress)\\l";
+                    for (Instruction *instr : inserts[edge]) {
+                        label += "insert: " + dotEscape(exprString(instr)) + "\\l";
+                    }
+                    style = ", color=red, penwidth=3";
+                } else if (std::count(hotEdges.begin(), hotEdges.end(), edge)) {
+                    style = ", penwidth=2";
+                } else {
+                    style = ", style=dashed, color=gray40";
+                }
+                *os << "    \"" << dotEscape(edge.first) << "\" -> \"" << dotEscape(edge.second)
+                    << "\" [label=\"" << label << "\"" << style << "];\n";
+            }
+        }
+        *os << "}\n";
+    }
+
+    BasicBlock *findBlock(Function &F, StringRef name) {
+        for (BasicBlock &BB : F) {
+            if (BB.getName() == name) {
+                return &BB;
+            }
+        }
+        return nullptr;
+    }
+
+    // Profile count of a block, or its static frequency estimate in a function without one
+    uint64_t getBlockCount(BasicBlock *BB) {
         BlockFrequencyInfo &bfi = getAnalysis<BlockFrequencyInfoWrapperPass>().getBFI();
+        if (usesStaticEstimates) {
+            return bfi.getBlockFreq(BB).getFrequency();
+        }
+        return bfi.getBlockProfileCount(BB).getValueOr(0);
+    }
+
+    uint64_t getEdgeCount(BasicBlock *from, BasicBlock *to) {
+        BranchProbabilityInfo &bpi = getAnalysis<BranchProbabilityInfoWrapperPass>().getBPI();
+        return bpi.getEdgeProbability(from, to).scale(getBlockCount(from));
+    }
+
+    // Innermost loop containing both from and to, null if there is none
+    Loop *getCommonLoop(BasicBlock *from, BasicBlock *to) {
+        Loop *L = getAnalysis<LoopInfoWrapperPass>().getLoopInfo().getLoopFor(from);
+        while (L && !L->contains(to)) {
+            L = L->getParentLoop();
+        }
+        return L;
+    }
+
+    // Count that the counts of blocks and edges in loop L are scaled by. With
+    // -ispre-loop-relative it is the count of L's header, so that the body of every loop gets
+    // its own hot region entered from its preheader; otherwise, and outside loops, it is the
+    // count of the hottest block of the function.
+    uint64_t getReferenceCount(Loop *L, uint64_t maxCount) {
+        return LoopRelative && L ? getBlockCount(L->getHeader()) : maxCount;
+    }
+
+    // Cut-off picked from the block counts of F relative to its hottest block, sorted from the
+    // hottest down: in the widest gap between two consecutive counts (gap), or right below the
+    // counts that cover -ispre-coverage of all block executions (coverage). It sits halfway
+    // between the last hot count and the next one down, and is the cut-off of the first stage:
+    // the result is scaled to this stage. Without counts it is this stage's Threshold.
+    double chooseThreshold(Function &F) {
+        // Executions are summed in double: a few blocks near UINT64_MAX would wrap a uint64_t
+        // sum, and saturating it would make the hottest key alone cover everything
+        std::map<uint64_t, double, std::greater<uint64_t>> executions;
+        double total = 0;
+        for (BasicBlock &BB : F) {
+            uint64_t count = getBlockCount(&BB);
+            executions[count] += count;
+            total += count;
+        }
+        if (executions.empty() || executions.begin()->first == 0) {
+            return Threshold;
+        }
+        double maxCount = (double)executions.begin()->first;
+        std::vector<double> scaled;
+        for (auto &entry : executions) {
+            scaled.push_back((double)entry.first / maxCount);
+        }
+        scaled.push_back(0);
+
+        size_t last = 0;
+        if (AdaptiveThreshold == AdaptiveThresholdKind::Gap) {
+            for (size_t i = 1; i + 1 < scaled.size(); i++) {
+                if (scaled[i] - scaled[i + 1] > scaled[last] - scaled[last + 1]) {
+                    last = i;
+                }
+            }
+        } else {
+            double covered = 0;
+            for (auto &entry : executions) {
+                covered += entry.second;
+                if (covered >= CoverageTarget * total) {
+                    break;
+                }
+                last++;
+            }
+            last = std::min(last, scaled.size() - 2);
+        }
+        return (scaled[last] + scaled[last + 1]) / 2 * Threshold / FIRST_STAGE_THRESHOLD;
+    }
+
+    // Whether a count is hot for the whole module, at -ispre-hot-percentile of its profile
+    // summary; a block hot only relative to the rest of a lukewarm function is not
+    bool isHotInModule(uint64_t count) {
+        return !psi || HotPercentile == 0 || psi->isHotCountNthPercentile(HotPercentile, count);
+    }
+
+    // Whether the block of a terminator (operand 1) or one of its successor edges (operand
+    // 2 + successor) is hot under a quorum of the workload weight recorded by -ispre-workloads.
+    // Without that metadata every block and edge passes. The recorded counts are relative to
+    // the hottest block; with -ispre-loop-relative they are rescaled to the header of L, the
+    // innermost loop of the block or edge, under the same workload.
+    bool isHotInWorkloads(BasicBlock *BB, unsigned operand, Loop *L) {
+        MDNode *workloads = BB->getTerminator()->getMetadata("ispre.workloads");
+        if (!workloads) {
+            return true;
+        }
+        MDNode *headers =
+            LoopRelative && L ? L->getHeader()->getTerminator()->getMetadata("ispre.workloads")
+                              : nullptr;
+        auto value = [](MDNode *workload, unsigned operand) {
+            return mdconst::extract<ConstantFP>(workload->getOperand(operand))
+                ->getValueAPF()
+                .convertToDouble();
+        };
+        double total = 0;
+        double hot = 0;
+        for (unsigned i = 0; i < workloads->getNumOperands(); i++) {
+            auto *workload = cast<MDNode>(workloads->getOperand(i));
+            if (operand >= workload->getNumOperands()) {
+                return true;
+            }
+            double weight = value(workload, 0);
+            double scaled = value(workload, operand);
+            if (headers && i < headers->getNumOperands()) {
+                double reference = value(cast<MDNode>(headers->getOperand(i)), 1);
+                scaled = reference > 0 ? scaled / reference : 0;
+            }
+            total += weight;
+            if (scaled > threshold) {
+                hot += weight;
+            }
+        }
+        return total <= 0 || hot >= WorkloadQuorum * total;
+    }
+
+    std::string exprString(Instruction *instr) {
+        auto printed = exprStrings.find(instr);
+        if (printed != exprStrings.end()) {
+            return printed->second;
+        }
+        std::string str;
+        raw_string_ostream os(str);
+        instr->print(os);
+        return StringRef(os.str()).trim().str();
+    }
+
+    // Site of an expression, which names its runtime counter and its deny list entry:
+    // <pass>:<block>:<index among the binary operators of the block>. Slot numbers would change
+    // with every instruction added in front, but the pass only adds binary operators at the end
+    // of blocks, besides the counter increments that are skipped here, so the site of an
+    // expression stays the same whatever earlier passes or builds speculated.
+    std::string siteName(Instruction *instr) {
+        auto captured = siteNames.find(instr);
+        if (captured != siteNames.end()) {
+            return captured->second;
+        }
+        unsigned index = 0;
+        for (Instruction &I : *instr->getParent()) {
+            if (&I == instr) {
+                break;
+            }
+            if (isa<BinaryOperator>(I) && !I.getMetadata("ispre.counter")) {
+                index++;
+            }
+        }
+        return (Twine(passName) + ":" + instr->getParent()->getName() + ":" + Twine(index))
+            .str();
+    }
+
+    void captureNames(Function &F) {
+        exprStrings.clear();
+        siteNames.clear();
+        ModuleSlotTracker MST(F.getParent());
+        MST.incorporateFunction(F);
+        for (Instruction &I : instructions(F)) {
+            std::string str;
+            raw_string_ostream os(str);
+            I.print(os, MST);
+            exprStrings[&I] = StringRef(os.str()).trim().str();
+            if (isa<BinaryOperator>(I)) {
+                siteNames[&I] = siteName(&I);
+            }
+        }
+    }
 
-        int maxCount = -1;
+    // Counts stay 64-bit: profiles of long-running programs exceed 2^31 per block. Only the
+    // count relative to the hottest block is kept in freqs.
+    uint64_t calculateHotColdNodes(Function &F, std::map<StringRef, double> &freqs,
+                                   std::vector<StringRef> &hotNodes,
+                                   std::vector<StringRef> &coldNodes) {
+        PhaseScope phase(passName, "calculateHotColdNodes", "Classify hot and cold nodes");
+        uint64_t maxCount = 0;
+        std::set<StringRef> workloadCold;
+        std::set<StringRef> moduleCold;
+        std::map<StringRef, Loop *> loops;
         for (BasicBlock &BB : F) {
-            int freq = bfi.getBlockProfileCount(&BB).getValue();
-            freqs[BB.getName()] = freq;
-            if (freq > maxCount) {
-                maxCount = freq;
+            uint64_t count = getBlockCount(&BB);
+            freqs[BB.getName()] = (double)count;
+            loops[BB.getName()] = getCommonLoop(&BB, &BB);
+            maxCount = std::max(maxCount, count);
+            if (!isHotInWorkloads(&BB, 1, loops[BB.getName()])) {
+                workloadCold.insert(BB.getName());
+            }
+            if (!isHotInModule(count)) {
+                moduleCold.insert(BB.getName());
             }
         }
 
         for (auto i = freqs.begin(); i != freqs.end(); i++) {
-            i->second = i->second / maxCount;
-            if (i->second > THRESHOLD) {
+            uint64_t reference = getReferenceCount(loops[i->first], maxCount);
+            if (reference != maxCount && i->second > threshold * (double)reference &&
+                !(i->second > threshold * (double)maxCount)) {
+                ++NumLoopHot;
+            }
+            i->second = reference ? i->second / (double)reference : 0;
+            bool hot = usesPathProfile ? pathHotNodes.count(i->first) > 0 : i->second > threshold;
+            if (hot && moduleCold.count(i->first)) {
+                ++NumModuleCold;
+                coldNodes.push_back(i->first);
+            } else if (hot && workloadCold.count(i->first)) {
+                ++NumWorkloadCold;
+                coldNodes.push_back(i->first);
+            } else if (hot) {
                 hotNodes.push_back(i->first);
             } else {
                 coldNodes.push_back(i->first);
@@ -149,18 +634,30 @@ struct ISPREPass : public FunctionPass {
         return maxCount;
     }
 
-    void calculateHotColdEdges(Function &F, std::map<StringRef, double> &freqs,
-                               std::vector<std::pair<StringRef, StringRef>> &hotEdges,
+    void calculateHotColdEdges(Function &F, std::vector<std::pair<StringRef, StringRef>> &hotEdges,
                                std::vector<std::pair<StringRef, StringRef>> &coldEdges,
-                               int maxCount) {
-        BranchProbabilityInfo &bpi = getAnalysis<BranchProbabilityInfoWrapperPass>().getBPI();
+                               uint64_t maxCount) {
+        PhaseScope phase(passName, "calculateHotColdEdges", "Classify hot and cold edges");
         for (BasicBlock &BB : F) {
+            unsigned operand = 2;
             for (BasicBlock *successor : successors(&BB)) {
-                BranchProbability edgeProb = bpi.getEdgeProbability(&BB, successor);
-                const uint64_t val = (uint64_t)(freqs[BB.getName()] * maxCount);
-                int edgeProb2 = edgeProb.scale(val);
-                double scaled = (double)edgeProb2 / maxCount;
-                if (scaled > THRESHOLD) {
+                // BranchProbability::scale does not overflow on 64-bit counts
+                uint64_t count = getEdgeCount(&BB, successor);
+                Loop *L = getCommonLoop(&BB, successor);
+                uint64_t reference = getReferenceCount(L, maxCount);
+                double scaled = reference ? (double)count / (double)reference : 0;
+                bool hot = usesPathProfile
+                               ? pathHotEdges.count({BB.getName(), successor->getName()}) > 0
+                               : scaled > threshold;
+                if (hot && !isHotInModule(count)) {
+                    ++NumModuleCold;
+                    hot = false;
+                }
+                bool quorum = isHotInWorkloads(&BB, operand++, L);
+                if (hot && !quorum) {
+                    ++NumWorkloadCold;
+                }
+                if (hot && quorum) {
                     hotEdges.push_back(std::make_pair(BB.getName(), successor->getName()));
                 } else {
                     coldEdges.push_back(std::make_pair(BB.getName(), successor->getName()));
@@ -172,6 +669,7 @@ struct ISPREPass : public FunctionPass {
     void calculateIngressEdges(std::vector<std::pair<StringRef, StringRef>> &coldEdges,
                                std::vector<StringRef> &hotNodes, std::vector<StringRef> &coldNodes,
                                std::vector<std::pair<StringRef, StringRef>> &ingressEdges) {
+        PhaseScope phase(passName, "calculateIngressEdges", "Find ingress edges");
         for (auto i : coldEdges) {
             if (std::count(coldNodes.begin(), coldNodes.end(), i.first) &&
                 std::count(hotNodes.begin(), hotNodes.end(), i.second)) {
@@ -185,6 +683,7 @@ struct ISPREPass : public FunctionPass {
                                 std::map<StringRef, std::set<Instruction *>> &needins,
                                 std::map<StringRef, std::set<Instruction *>> &needouts,
                                 Function &F) {
+        PhaseScope phase(passName, "compute_needin_needout", "Solve need dataflow");
         // Init NEEDIN(X) to 0 for all basic blocks X
         for (BasicBlock &BB : F) {
             std::set<Instruction *> empty_set;
@@ -194,6 +693,7 @@ struct ISPREPass : public FunctionPass {
         int change = 1;
         while (change) {
             change = 0;
+            ++NumNeedIterations;
             for (BasicBlock &BB : F) {
                 auto bb_name = BB.getName();
                 std::set<Instruction *> old_needin = needins[bb_name];
@@ -230,6 +730,7 @@ struct ISPREPass : public FunctionPass {
                     std::map<StringRef, std::set<Instruction *>> needins,
                     std::map<StringRef, std::set<Instruction *>> avouts,
                     std::map<std::pair<StringRef, StringRef>, std::set<Instruction *>> &inserts) {
+        PhaseScope phase(passName, "compute_inserts", "Compute inserts");
         for (auto itr = ingressEdges.begin(); itr != ingressEdges.end(); itr++) {
             StringRef u = itr->first;
             StringRef v = itr->second;
@@ -246,6 +747,7 @@ struct ISPREPass : public FunctionPass {
     // e. Get loads and their corresponding sources. For each load, look through all stores for
     // matching destination of store If found then e is killed and does not go into xUses
     void fillXUses(Function &F, std::map<StringRef, std::set<Instruction *>> &xUses) {
+        PhaseScope phase(passName, "fillXUses", "Compute exposed uses");
         for (BasicBlock &BB : F) // for each BB
         {
             for (auto &instr : BB) // for each instruction e within a block
@@ -331,6 +833,7 @@ struct ISPREPass : public FunctionPass {
     // sources. For each load, look through all stores for matching destination of store after e
     // If found then e is killed and does not go into gens
     void fillGens(Function &F, std::map<StringRef, std::set<Instruction *>> &gens) {
+        PhaseScope phase(passName, "fillGens", "Compute gens");
         for (BasicBlock &BB : F) {
 
             for (auto &instr : BB) {
@@ -421,6 +924,7 @@ struct ISPREPass : public FunctionPass {
     // get load's operand and search for corresponding store with same dest. If found, enter
     // into kills set
     void fillKills(Function &F, std::map<StringRef, std::set<Instruction *>> &kills) {
+        PhaseScope phase(passName, "fillKills", "Compute kills");
         for (BasicBlock &BB : F) {
 
             for (auto &instr : BB) {
@@ -538,6 +1042,7 @@ struct ISPREPass : public FunctionPass {
     void fillCandidates(std::vector<StringRef> hotNodes,
                         std::map<StringRef, std::set<Instruction *>> &xUses,
                         std::set<Instruction *> &candidates) {
+        PhaseScope phase(passName, "fillCandidates", "Compute candidates");
         for (auto &xUseBB : xUses) {
             if (std::find(hotNodes.begin(), hotNodes.end(), xUseBB.first) != hotNodes.end()) {
                 std::set_union(candidates.begin(), candidates.end(), xUseBB.second.begin(),
@@ -546,12 +1051,34 @@ struct ISPREPass : public FunctionPass {
         }
     }
 
+    // Expressions whose speculation an earlier instrumented run found unprofitable are moved
+    // from removables to denied: nothing needs them, so they are neither replaced nor inserted
+    void removeDeniedExpressions(Function &F,
+                                 std::map<StringRef, std::set<Instruction *>> &removables,
+                                 std::set<Instruction *> &denied) {
+        PhaseScope phase(passName, "removeDeniedExpressions", "Apply the deny list");
+        for (auto &pair : removables) {
+            for (Instruction *instr : pair.second) {
+                if (findDeniedSpeculation(DenyListFile, F.getName(), siteName(instr))) {
+                    denied.insert(instr);
+                }
+            }
+        }
+        for (auto &pair : removables) {
+            for (Instruction *instr : denied) {
+                pair.second.erase(instr);
+            }
+        }
+        NumDenied += denied.size();
+    }
+
     void fillAvinAvouts(std::set<Instruction *> candidates,
                         std::map<StringRef, std::set<Instruction *>> gens,
                         std::map<StringRef, std::set<Instruction *>> kills,
                         std::vector<std::pair<StringRef, StringRef>> ingressEdges,
                         std::map<StringRef, std::set<Instruction *>> &avouts,
                         std::map<StringRef, std::set<Instruction *>> &avins, Function &F) {
+        PhaseScope phase(passName, "fillAvinAvouts", "Solve availability dataflow");
         // Init AVOUT(b) to 0 for all basic blocks X
         for (BasicBlock &BB : F) {
             std::set<Instruction *> empty_set;
@@ -561,6 +1088,7 @@ struct ISPREPass : public FunctionPass {
         int change = 1;
         while (change) {
             change = 0;
+            ++NumAvailIterations;
             for (BasicBlock &BB : F) {
                 auto bb_name = BB.getName();
                 std::set<Instruction *> old_avout = avouts[bb_name];
@@ -611,6 +1139,7 @@ struct ISPREPass : public FunctionPass {
                         std::map<StringRef, std::set<Instruction *>> avins,
                         std::vector<StringRef> hotNodes,
                         std::map<StringRef, std::set<Instruction *>> &removables, Function &F) {
+        PhaseScope phase(passName, "fillRemovables", "Compute removables");
         for (BasicBlock &BB : F) {
             auto bb_name = BB.getName();
             if (std::find(hotNodes.begin(), hotNodes.end(), bb_name) != hotNodes.end()) {
@@ -624,9 +1153,196 @@ struct ISPREPass : public FunctionPass {
         }
     }
 
+    // Explain every exposed use that will not be rewritten: uses in cold blocks are never
+    // candidates, and a hot candidate stays unless it is available on entry to its block, which
+    // fails when it is killed inside the hot region or the hot region is entered by an edge
+    // that is not an ingress edge
+    void emitMissedRemarks(std::vector<StringRef> &hotNodes, std::vector<StringRef> &coldNodes,
+                           std::vector<std::pair<StringRef, StringRef>> &ingressEdges,
+                           std::map<StringRef, std::set<Instruction *>> &xUses,
+                           std::map<StringRef, std::set<Instruction *>> &kills,
+                           std::map<StringRef, std::set<Instruction *>> &avouts,
+                           std::map<StringRef, std::set<Instruction *>> &removables,
+                           std::map<std::pair<StringRef, StringRef>, std::set<Instruction *>>
+                               &inserts,
+                           std::set<Instruction *> &denied, OptimizationRemarkEmitter &ORE,
+                           Function &F) {
+        PhaseScope phase(passName, "emitMissedRemarks", "Emit missed remarks");
+        if (!ORE.allowExtraAnalysis(passName)) {
+            return;
+        }
+
+        std::set<Instruction *> inserted;
+        for (auto &pair : inserts) {
+            inserted.insert(pair.second.begin(), pair.second.end());
+        }
+
+        // Edges entering the hot region from a cold block that were not classified as ingress
+        std::vector<std::pair<StringRef, StringRef>> nonIngressEntries;
+        for (StringRef hotNode : hotNodes) {
+            BasicBlock *hotBB = findBlock(F, hotNode);
+            for (BasicBlock *predecessor : predecessors(hotBB)) {
+                std::pair<StringRef, StringRef> edge =
+                    std::make_pair(predecessor->getName(), hotNode);
+                if (std::count(coldNodes.begin(), coldNodes.end(), edge.first) &&
+                    !std::count(ingressEdges.begin(), ingressEdges.end(), edge)) {
+                    nonIngressEntries.push_back(edge);
+                }
+            }
+        }
+
+        for (auto &pair : xUses) {
+            BasicBlock *BB = findBlock(F, pair.first);
+            bool isHot = std::count(hotNodes.begin(), hotNodes.end(), pair.first);
+            for (Instruction *instr : pair.second) {
+                if (inserted.count(instr)) {
+                    continue;
+                }
+                if (denied.count(instr)) {
+                    const SpeculationCount *count =
+                        findDeniedSpeculation(DenyListFile, F.getName(), siteName(instr));
+                    ORE.emit([&]() {
+                        return OptimizationRemarkMissed(passName, "DenyListed", instr)
+                               << "not speculated " << ore::NV("Expression", exprString(instr))
+                               << ": deny-listed after its speculated value was used "
+                               << ore::NV("Saved", count->saved) << " times for "
+                               << ore::NV("Added", count->added) << " insertions"
+                               << ore::setExtraArgs() << ore::NV("Site", siteName(instr));
+                    });
+                    continue;
+                }
+                if (!isHot) {
+                    ORE.emit([&]() {
+                        return OptimizationRemarkMissed(passName, "ColdUseSite", instr)
+                               << "not speculated " << ore::NV("Expression", exprString(instr))
+                               << ": use site " << ore::NV("Block", BB->getName())
+                               << " is cold (count " << ore::NV("BlockCount", getBlockCount(BB))
+                               << ")" << ore::setExtraArgs() << ore::NV("Site", siteName(instr));
+                    });
+                    continue;
+                }
+
+                // The non-ingress entries that do not bring the expression into the hot region
+                std::vector<std::pair<BasicBlock *, BasicBlock *>> blockingEntries;
+                for (auto &edge : nonIngressEntries) {
+                    if (!avouts[edge.first].count(instr)) {
+                        blockingEntries.push_back(
+                            std::make_pair(findBlock(F, edge.first), findBlock(F, edge.second)));
+                    }
+                }
+
+                StringRef killBlock;
+                for (StringRef hotNode : hotNodes) {
+                    if (kills[hotNode].count(instr)) {
+                        killBlock = hotNode;
+                        break;
+                    }
+                }
+                if (!killBlock.empty()) {
+                    ORE.emit([&]() {
+                        return OptimizationRemarkMissed(passName, "KilledInHotRegion", instr)
+                               << "not speculated " << ore::NV("Expression", exprString(instr))
+                               << ": killed in hot block " << ore::NV("KillBlock", killBlock)
+                               << " (use count " << ore::NV("BlockCount", getBlockCount(BB))
+                               << ")" << ore::setExtraArgs() << ore::NV("Site", siteName(instr));
+                    });
+                } else if (!blockingEntries.empty()) {
+                    ORE.emit([&]() {
+                        OptimizationRemarkMissed remark(passName, "NonIngressEdge", instr);
+                        remark << "not speculated " << ore::NV("Expression", exprString(instr))
+                               << ": not available on non-ingress "
+                               << (blockingEntries.size() == 1 ? "edge " : "edges ");
+                        for (auto &edge : blockingEntries) {
+                            if (&edge != &blockingEntries.front()) {
+                                remark << ", ";
+                            }
+                            remark << ore::NV("EdgeSource", edge.first->getName()) << " -> "
+                                   << ore::NV("EdgeTarget", edge.second->getName())
+                                   << " (edge count "
+                                   << ore::NV("EdgeCount", getEdgeCount(edge.first, edge.second))
+                                   << ")";
+                        }
+                        remark << " into the hot region (use count "
+                               << ore::NV("BlockCount", getBlockCount(BB)) << ")"
+                               << ore::setExtraArgs() << ore::NV("Site", siteName(instr));
+                        return remark;
+                    });
+                } else if (!removables[pair.first].count(instr)) {
+                    ORE.emit([&]() {
+                        return OptimizationRemarkMissed(passName, "NotAvailable", instr)
+                               << "not speculated " << ore::NV("Expression", exprString(instr))
+                               << ": not available on entry to " << ore::NV("Block", BB->getName())
+                               << " (use count " << ore::NV("BlockCount", getBlockCount(BB))
+                               << ")" << ore::setExtraArgs() << ore::NV("Site", siteName(instr));
+                    });
+                } else {
+                    ORE.emit([&]() {
+                        return OptimizationRemarkMissed(passName, "NoInsertion", instr)
+                               << "not speculated " << ore::NV("Expression", exprString(instr))
+                               << ": already available on every ingress edge (use count "
+                               << ore::NV("BlockCount", getBlockCount(BB)) << ")"
+                               << ore::setExtraArgs() << ore::NV("Site", siteName(instr));
+                    });
+                }
+            }
+        }
+    }
+
+    // Create the runtime record of expr, laid out as struct ispre_counter in
+    // runtime/ispre_rt.c; the runtime finds every record through the ispre_counters section
+    GlobalVariable *createCounter(Function &F, Instruction *expr) {
+        Module &M = *F.getParent();
+        LLVMContext &ctx = F.getContext();
+        StructType *counterTy = StructType::getTypeByName(ctx, "struct.ispre_counter");
+        if (!counterTy) {
+            Type *i64Ty = Type::getInt64Ty(ctx);
+            Type *strTy = Type::getInt8PtrTy(ctx);
+            counterTy = StructType::create(ctx, {i64Ty, i64Ty, strTy, strTy, strTy},
+                                           "struct.ispre_counter");
+        }
+
+        if (!M.getNamedGlobal("__ispre_runtime_user")) {
+            // Referencing the runtime's hook pulls ispre_rt.o out of libispre_rt.a
+            Constant *hook = M.getOrInsertGlobal("__ispre_runtime", Type::getInt32Ty(ctx));
+            GlobalVariable *user =
+                new GlobalVariable(M, hook->getType(), true, GlobalValue::LinkOnceODRLinkage, hook,
+                                   "__ispre_runtime_user");
+            user->setVisibility(GlobalValue::HiddenVisibility);
+            appendToCompilerUsed(M, {user});
+        }
+
+        IRBuilder<> IRB(ctx);
+        Constant *zero = ConstantInt::get(Type::getInt64Ty(ctx), 0);
+        Constant *init = ConstantStruct::get(
+            counterTy, {zero, zero, IRB.CreateGlobalStringPtr(F.getName(), "", 0, &M),
+                        IRB.CreateGlobalStringPtr(siteName(expr), "", 0, &M),
+                        IRB.CreateGlobalStringPtr(exprString(expr), "", 0, &M)});
+        GlobalVariable *counter = new GlobalVariable(M, counterTy, false,
+                                                     GlobalValue::PrivateLinkage, init,
+                                                     "__ispre_counter");
+        counter->setSection("ispre_counters");
+        counter->setAlignment(Align(8));
+        appendToCompilerUsed(M, {counter});
+        return counter;
+    }
+
+    // field 0 counts executions saved at the replaced site, field 1 executions added on edges.
+    // The increment is marked so that siteName does not count it.
+    void incrementCounter(GlobalVariable *counter, unsigned field, Instruction *insertBefore) {
+        IRBuilder<> IRB(insertBefore);
+        Value *addr = IRB.CreateStructGEP(counter->getValueType(), counter, field);
+        Value *count = IRB.CreateLoad(IRB.getInt64Ty(), addr);
+        auto *increment = cast<Instruction>(IRB.CreateAdd(count, IRB.getInt64(1)));
+        increment->setMetadata("ispre.counter", MDNode::get(IRB.getContext(), {}));
+        IRB.CreateStore(increment, addr);
+    }
+
     void performRemoveAndInsert(
         std::map<std::pair<StringRef, StringRef>, std::set<Instruction *>> &inserts,
-        std::map<Instruction *, Instruction *> &allocas, Function &F) {
+        std::map<Instruction *, Instruction *> &allocas, OptimizationRemarkEmitter &ORE,
+        Function &F) {
+        std::map<Instruction *, GlobalVariable *> counters;
+        PhaseScope phase(passName, "performRemoveAndInsert", "Remove and insert expressions");
         for (auto &pair : inserts) {
             BasicBlock &entry = F.getEntryBlock();
             Instruction *firstPossInsert = F.getEntryBlock().getFirstNonPHI();
@@ -648,6 +1364,10 @@ struct ISPREPass : public FunctionPass {
                     IRB.SetInsertPoint(firstPossInsert);
                     alloc = IRB.CreateAlloca(allInstrInBB->getType());
                     allocas[allInstrInBB] = alloc;
+                    ++NumAllocas;
+                    if (Instrument) {
+                        counters[allInstrInBB] = createCounter(F, allInstrInBB);
+                    }
                 }
 
                 for (Use &U : allInstrInBB->operands()) {
@@ -669,16 +1389,50 @@ struct ISPREPass : public FunctionPass {
                 IRBuilder<> IRB2(toInsert);
                 IRB2.SetInsertPoint(insertBefore);
                 IRB2.CreateStore(clone, alloc);
+                ++NumInserts;
+                if (Instrument) {
+                    incrementCounter(counters[allInstrInBB], 1, insertBefore);
+                }
+                BasicBlock *ingressTarget = findBlock(F, pair.first.second);
+                ORE.emit([&]() {
+                    return OptimizationRemark(passName, "Speculated", clone)
+                           << "speculated " << ore::NV("Expression", exprString(allInstrInBB))
+                           << " on ingress edge " << ore::NV("IngressSource", toInsert->getName())
+                           << " -> " << ore::NV("IngressTarget", ingressTarget->getName())
+                           << " (edge count "
+                           << ore::NV("EdgeCount", getEdgeCount(toInsert, ingressTarget))
+                           << ", source count " << ore::NV("SourceCount", getBlockCount(toInsert))
+                           << ")";
+                });
 
                 IRBuilder<> IRB3(allInstrInBB->getParent());
                 IRB3.SetInsertPoint(allInstrInBB);
                 Instruction *loadInst = IRB3.CreateLoad(allInstrInBB->getType(), alloc);
+                if (!allInstrInBB->use_empty()) {
+                    ++NumRemovals;
+                    if (Instrument) {
+                        incrementCounter(counters[allInstrInBB], 0, loadInst);
+                    }
+                    BasicBlock *useBlock = allInstrInBB->getParent();
+                    ORE.emit([&]() {
+                        return OptimizationRemark(passName, "Removed", allInstrInBB)
+                               << "replaced " << ore::NV("Expression", exprString(allInstrInBB))
+                               << " in " << ore::NV("Block", useBlock->getName())
+                               << " with value speculated on ingress edge "
+                               << ore::NV("IngressSource", toInsert->getName()) << " -> "
+                               << ore::NV("IngressTarget", ingressTarget->getName())
+                               << " (block count "
+                               << ore::NV("BlockCount", getBlockCount(useBlock)) << ")";
+                    });
+                }
                 allInstrInBB->replaceAllUsesWith(loadInst);
             }
         }
     }
 
-    bool runOnFunction(Function &F) override {
+    // One isothermal solve of F at the current threshold: blocks above it form the hot region,
+    // and the expressions it needs are speculated on its ingress edges
+    bool optimizeRegion(Function &F, OptimizationRemarkEmitter &ORE) {
         std::map<StringRef, double> freqs;
         std::vector<StringRef> hotNodes;
         std::vector<StringRef> coldNodes;
@@ -698,22 +1452,76 @@ struct ISPREPass : public FunctionPass {
         std::map<std::pair<StringRef, StringRef>, std::set<Instruction *>> inserts;
         std::map<Instruction *, Instruction *> allocas;
 
-        int maxCount = calculateHotColdNodes(F, freqs, hotNodes, coldNodes);
-        calculateHotColdEdges(F, freqs, hotEdges, coldEdges, maxCount);
+        std::set<BasicBlock *> pathBlocks;
+        std::set<std::pair<BasicBlock *, BasicBlock *>> pathEdges;
+        usesPathProfile = !PathProfileFile.empty() &&
+                          getHotPathRegion(F, PathProfileFile, threshold, pathBlocks, pathEdges);
+        pathHotNodes.clear();
+        pathHotEdges.clear();
+        if (usesPathProfile) {
+            ++NumPathRegions;
+            for (BasicBlock *BB : pathBlocks) {
+                pathHotNodes.insert(BB->getName());
+            }
+            for (auto &edge : pathEdges) {
+                pathHotEdges.insert({edge.first->getName(), edge.second->getName()});
+            }
+        }
+
+        uint64_t maxCount = calculateHotColdNodes(F, freqs, hotNodes, coldNodes);
+        calculateHotColdEdges(F, hotEdges, coldEdges, maxCount);
         calculateIngressEdges(coldEdges, hotNodes, coldNodes, ingressEdges);
+        NumIngressEdges += ingressEdges.size();
 
         fillXUses(F, xUses);
         fillGens(F, gens);
         fillKills(F, kills);
 
         fillCandidates(hotNodes, xUses, candidates);
+        NumCandidates += candidates.size();
         fillAvinAvouts(candidates, gens, kills, ingressEdges, avouts, avins, F);
         fillRemovables(xUses, avins, hotNodes, removables, F);
+        std::set<Instruction *> denied;
+        if (!DenyListFile.empty()) {
+            removeDeniedExpressions(F, removables, denied);
+        }
 
         compute_needin_needout(removables, gens, needins, needouts, F);
         compute_inserts(ingressEdges, needins, avouts, inserts);
 
-        performRemoveAndInsert(inserts, allocas, F);
+        if (!DumpJSONDir.empty()) {
+            dumpJSON(F, maxCount, freqs, hotNodes, hotEdges, ingressEdges, xUses, gens, kills,
+                     candidates, avins, avouts, removables, needins, needouts, inserts);
+        }
+        if (!DumpDotDir.empty()) {
+            dumpDot(F, freqs, hotNodes, hotEdges, ingressEdges, inserts);
+        }
+
+        // Static estimates can be far from the real counts, so only a few speculations are
+        // trusted to them
+        if (usesStaticEstimates) {
+            unsigned numInserts = 0;
+            for (auto &pair : inserts) {
+                numInserts += pair.second.size();
+            }
+            if (numInserts > StaticMaxInserts) {
+                ++NumStaticCapped;
+                ORE.emit([&]() {
+                    return OptimizationRemarkMissed(passName, "SpeculationCap",
+                                                    F.getSubprogram(), &F.getEntryBlock())
+                           << "not speculated in " << ore::NV("Function", F.getName()) << ": "
+                           << ore::NV("Inserts", numInserts)
+                           << " insertions exceed the cap of "
+                           << ore::NV("Cap", StaticMaxInserts.getValue())
+                           << " for static estimates";
+                });
+                return false;
+            }
+        }
+
+        emitMissedRemarks(hotNodes, coldNodes, ingressEdges, xUses, kills, avouts, removables,
+                          inserts, denied, ORE, F);
+        performRemoveAndInsert(inserts, allocas, ORE, F);
 
         // Uncomment below line to print out all intermediate data
         /*printAll(hotNodes, coldNodes, hotEdges, coldEdges, ingressEdges, xUses, gens, kills,
@@ -722,13 +1530,145 @@ struct ISPREPass : public FunctionPass {
         return true;
     }
 
+    bool runOnFunction(Function &F) override {
+        OptimizationRemarkEmitter &ORE =
+            getAnalysis<OptimizationRemarkEmitterWrapperPass>().getORE();
+        usesStaticEstimates = !F.hasProfileData();
+        if (usesStaticEstimates) {
+            if (!StaticProfile) {
+                ++NumNoProfile;
+                ORE.emit([&]() {
+                    return OptimizationRemarkMissed(passName, "NoProfile", F.getSubprogram(),
+                                                    &F.getEntryBlock())
+                           << "function " << ore::NV("Function", F.getName())
+                           << " has no profile (use -ispre-static-profile to estimate one)";
+                });
+                return false;
+            }
+            ++NumStaticFunctions;
+        }
+        psi = nullptr;
+        if (!usesStaticEstimates) {
+            ProfileSummaryInfo &summary = getAnalysis<ProfileSummaryInfoWrapperPass>().getPSI();
+            psi = summary.hasProfileSummary() ? &summary : nullptr;
+        }
+        if (psi && ColdPercentile != 0) {
+            // Functions that barely run are not worth analyzing: compare the entry and the
+            // hottest block with the cold counts of the whole module
+            uint64_t entryCount = getBlockCount(&F.getEntryBlock());
+            uint64_t maxCount = 0;
+            for (BasicBlock &BB : F) {
+                maxCount = std::max(maxCount, getBlockCount(&BB));
+            }
+            if (psi->isColdCountNthPercentile(ColdPercentile, entryCount) &&
+                psi->isColdCountNthPercentile(ColdPercentile, maxCount)) {
+                ++NumColdFunctions;
+                NumColdFunctionBlocks += F.size();
+                ORE.emit([&]() {
+                    return OptimizationRemarkMissed(passName, "ColdFunction", F.getSubprogram(),
+                                                    &F.getEntryBlock())
+                           << "function " << ore::NV("Function", F.getName())
+                           << " skipped as cold in the module (entry count "
+                           << ore::NV("EntryCount", entryCount) << ", max count "
+                           << ore::NV("MaxCount", maxCount) << ")";
+                });
+                return false;
+            }
+        }
+
+        // The bands already nest the temperatures the cascade approximates, so only its first
+        // pass solves them; the later passes keep their own thresholds
+        bool usesBands = !Bands.empty() && StringRef(passName) == "ispre";
+        threshold = Threshold;
+        if (AdaptiveThreshold != AdaptiveThresholdKind::None && !usesBands) {
+            threshold = chooseThreshold(F);
+            ORE.emit([&]() {
+                return OptimizationRemarkAnalysis(passName, "AdaptiveThreshold",
+                                                  F.getSubprogram(), &F.getEntryBlock())
+                       << "threshold of " << ore::NV("Function", F.getName()) << " set to "
+                       << ore::NV("Threshold", formatv("{0:F4}", threshold).str())
+                       << " by its count distribution";
+            });
+        }
+
+        usesContextSensitiveProfile =
+            !usesStaticEstimates && F.getParent()->getProfileSummary(/*IsCS=*/true);
+        if (usesContextSensitiveProfile) {
+            ++NumContextSensitive;
+        }
+
+        captureNames(F);
+        if (!usesBands) {
+            return optimizeRegion(F, ORE);
+        }
+
+        // Solve every band boundary from the hottest down: expressions speculated into a warm
+        // block by one boundary are candidates of the next, so each ends up on the ingress
+        // edges of the coldest band that needs it. The CFG is unchanged, so the block
+        // frequencies stay valid across the solves.
+        std::vector<double> boundaries(Bands.begin(), Bands.end());
+        std::sort(boundaries.begin(), boundaries.end(), std::greater<double>());
+        bool changed = false;
+        band = 0;
+        for (double boundary : boundaries) {
+            band++;
+            threshold = boundary;
+            ++NumBands;
+            changed |= optimizeRegion(F, ORE);
+        }
+        band = 0;
+        return changed;
+    }
+
     void getAnalysisUsage(AnalysisUsage &AU) const override {
         AU.addRequired<BranchProbabilityInfoWrapperPass>();
         AU.addRequired<BlockFrequencyInfoWrapperPass>();
+        AU.addRequired<LoopInfoWrapperPass>();
+        AU.addRequired<OptimizationRemarkEmitterWrapperPass>();
+        AU.addRequired<ProfileSummaryInfoWrapperPass>();
     }
 };
+
+// Each pass of the cascade needs a class of its own for the legacy pass manager
+template <unsigned Stage> struct ISPREStagePass : public ISPREPass {
+    static char ID;
+    ISPREStagePass();
+};
+template <unsigned Stage> char ISPREStagePass<Stage>::ID = 0;
 } // namespace ISPRE
 
-char ISPRE::ISPREPass::ID = 0;
-static RegisterPass<ISPRE::ISPREPass>
-    X("ispre", "Isothermal Speculative Partial Redundancy Elimination", false, false);
+// Named after the registered pass, so every stage of a cascade can be tuned on its own
+static cl::opt<double> Threshold1("ispre-threshold",
+                                  cl::desc("Hot/cold cut-off relative to the hottest block of "
+                                           "the function, for -ispre"),
+                                  cl::init(ISPRE::FIRST_STAGE_THRESHOLD));
+static cl::opt<double> Threshold2("ispre2-threshold",
+                                  cl::desc("Hot/cold cut-off relative to the hottest block of "
+                                           "the function, for -ispre2"),
+                                  cl::init(0.45));
+static cl::opt<double> Threshold3("ispre3-threshold",
+                                  cl::desc("Hot/cold cut-off relative to the hottest block of "
+                                           "the function, for -ispre3"),
+                                  cl::init(0.11));
+static cl::opt<double> Threshold4("ispre4-threshold",
+                                  cl::desc("Hot/cold cut-off relative to the hottest block of "
+                                           "the function, for -ispre4"),
+                                  cl::init(0.22));
+
+template <> ISPRE::ISPREStagePass<1>::ISPREStagePass() : ISPREPass(ID, "ispre", Threshold1) {}
+template <> ISPRE::ISPREStagePass<2>::ISPREStagePass() : ISPREPass(ID, "ispre2", Threshold2) {}
+template <> ISPRE::ISPREStagePass<3>::ISPREStagePass() : ISPREPass(ID, "ispre3", Threshold3) {}
+template <> ISPRE::ISPREStagePass<4>::ISPREStagePass() : ISPREPass(ID, "ispre4", Threshold4) {}
+
+static RegisterPass<ISPRE::ISPREStagePass<1>>
+    X1("ispre", "Isothermal Speculative Partial Redundancy Elimination", false, false);
+static RegisterPass<ISPRE::ISPREStagePass<2>>
+    X2("ispre2", "Multipass (2) Isothermal Speculative Partial Redundancy Elimination", false,
+       false);
+// -ispre3 and -ispre4 have always run at 0.11 and 0.22, in this order
+static RegisterPass<ISPRE::ISPREStagePass<3>>
+    X3("ispre3", "Multipass (4) Isothermal Speculative Partial Redundancy Elimination", false,
+       false);
+static RegisterPass<ISPRE::ISPREStagePass<4>>
+    X4("ispre4", "Multipass (3) Isothermal Speculative Partial Redundancy Elimination", false,
+       false);
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//  Command line options shared by all ISPRE passes
+//
+////===----------------------------------------------------------------------===//
+#include "ISPREOptions.h"
+
+using namespace llvm;
+
+cl::opt<std::string> DumpJSONDir("ispre-dump-json",
+                                 cl::desc("Write the ISPRE decisions of every function as JSON "
+                                          "into this directory"),
+                                 cl::value_desc("dir"));
+
+cl::opt<std::string> DumpDotDir("ispre-dump-dot",
+                                cl::desc("Write a profile heat-map CFG of every function as DOT "
+                                         "into this directory"),
+                                cl::value_desc("dir"));
+
+cl::opt<bool> Instrument("ispre-instrument",
+                         cl::desc("Add runtime counters to speculated insertions and to the "
+                                  "expressions they replace (link with libispre_rt)"),
+                         cl::init(false));
+
+cl::opt<bool> StaticProfile("ispre-static-profile",
+                            cl::desc("Use static block frequency estimates (loop depth, "
+                                     "branch weights, cold calls) in functions without a "
+                                     "profile instead of skipping them"),
+                            cl::init(false));
+
+cl::opt<unsigned> StaticMaxInserts("ispre-static-max-inserts",
+                                   cl::desc("Leave a function classified by static estimates "
+                                            "unchanged if it needs more insertions than this"),
+                                   cl::init(4));
+
+cl::opt<double> WorkloadQuorum("ispre-workload-quorum",
+                               cl::desc("Fraction of the workload weight (see -ispre-workloads) "
+                                        "under which a block or edge must be hot to be hot"),
+                               cl::init(0.5));
+
+cl::opt<std::string> PathProfileFile("ispre-path-profile",
+                                     cl::desc("Build hot regions from the hottest acyclic paths "
+                                              "in this path profile (see ispre-path-profile-gen)"),
+                                     cl::value_desc("file"));
+
+cl::opt<unsigned> HotPercentile("ispre-hot-percentile",
+                                cl::desc("Percentile of the module profile summary, in parts per "
+                                         "million, that hot blocks and edges must reach (e.g. "
+                                         "990000; 0, the default, only compares within the "
+                                         "function)"),
+                                cl::init(0));
+
+cl::opt<unsigned> ColdPercentile("ispre-cold-percentile",
+                                 cl::desc("Skip functions whose entry and hottest block are cold "
+                                          "at this percentile of the module profile summary, in "
+                                          "parts per million (0 to analyze every function)"),
+                                 cl::init(999999));
+
+cl::opt<AdaptiveThresholdKind> AdaptiveThreshold(
+    "ispre-adaptive-threshold",
+    cl::desc("Pick each function's threshold from its own block count distribution"),
+    cl::values(clEnumValN(AdaptiveThresholdKind::None, "none", "Use the -<pass>-threshold option"),
+               clEnumValN(AdaptiveThresholdKind::Gap, "gap",
+                          "Cut at the widest gap between consecutive relative counts"),
+               clEnumValN(AdaptiveThresholdKind::Coverage, "coverage",
+                          "Keep the hottest blocks covering -ispre-coverage of executions")),
+    cl::init(AdaptiveThresholdKind::None));
+
+cl::opt<double> CoverageTarget("ispre-coverage",
+                               cl::desc("Fraction of block executions the hot blocks cover with "
+                                        "-ispre-adaptive-threshold=coverage"),
+                               cl::init(0.95));
+
+cl::opt<bool> LoopRelative("ispre-loop-relative",
+                           cl::desc("Classify blocks and edges inside a loop relative to the "
+                                    "count of its header, giving every loop its own hot region"),
+                           cl::init(false));
+
+cl::opt<std::string> DenyListFile("ispre-deny-list",
+                                  cl::desc("Do not speculate the expressions in this deny list "
+                                           "(see ispre-denylist)"),
+                                  cl::value_desc("file"));
+
+cl::list<double> Bands("ispre-bands",
+                       cl::desc("Nest temperature bands at these thresholds and move expressions "
+                                "outward across each band boundary, hottest first"),
+                       cl::value_desc("t1,t2,..."), cl::CommaSeparated);
@@ -0,0 +1,58 @@
+//===----------------------------------------------------------------------===//
+//
+//  Command line options shared by all ISPRE passes
+//
+////===----------------------------------------------------------------------===//
+#ifndef ISPRE_ISPREOPTIONS_H
+#define ISPRE_ISPREOPTIONS_H
+
+#include "llvm/Support/CommandLine.h"
+
+#include <string>
+
+// Directory receiving one JSON decision dump per function and pass
+extern llvm::cl::opt<std::string> DumpJSONDir;
+
+// Directory receiving one profile heat-map DOT graph per function and pass
+extern llvm::cl::opt<std::string> DumpDotDir;
+
+// Count executions of speculated insertions and of the expressions they replace at run time
+extern llvm::cl::opt<bool> Instrument;
+
+// Classify blocks by static frequency estimates in functions without a profile
+extern llvm::cl::opt<bool> StaticProfile;
+
+// Most expressions speculated on ingress edges of a function classified by static estimates
+extern llvm::cl::opt<unsigned> StaticMaxInserts;
+
+// Fraction of the workload weight under which a block or edge must be hot to be treated as hot
+extern llvm::cl::opt<double> WorkloadQuorum;
+
+// Ball-Larus path counts written by programs built with -ispre-path-profile-gen
+extern llvm::cl::opt<std::string> PathProfileFile;
+
+// Profile summary percentile a block or edge count must reach to be hot (0, the default, to not
+// check)
+extern llvm::cl::opt<unsigned> HotPercentile;
+
+// Profile summary percentile below which a function's entry and hottest block are cold, and
+// the function is skipped (0 to analyze every function)
+extern llvm::cl::opt<unsigned> ColdPercentile;
+
+// How each function's hot/cold cut-off is picked from its own block counts
+enum class AdaptiveThresholdKind { None, Gap, Coverage };
+extern llvm::cl::opt<AdaptiveThresholdKind> AdaptiveThreshold;
+
+// Fraction of a function's block executions the hot blocks cover in the coverage mode
+extern llvm::cl::opt<double> CoverageTarget;
+
+// Scale the counts inside a loop by its header's count instead of the hottest block's
+extern llvm::cl::opt<bool> LoopRelative;
+
+// Expressions not to speculate, written by ispre-denylist from the counts of -ispre-instrument
+extern llvm::cl::opt<std::string> DenyListFile;
+
+// Temperature band boundaries, each solved in turn from the hottest down in a single pass
+extern llvm::cl::list<double> Bands;
+
+#endif // ISPRE_ISPREOPTIONS_H
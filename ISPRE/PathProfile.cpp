@@ -0,0 +1,392 @@
+//===----------------------------------------------------------------------===//
+//
+//  Ball-Larus path profiling for the ISPRE passes
+//
+//  -ispre-path-profile-gen numbers the acyclic paths of every function and adds a register
+//  that sums the values of the edges taken, so that at every return and back edge it holds
+//  the number of the path just completed, whose counter is then incremented. The counters are
+//  laid out as struct ispre_path_table in runtime/ispre_rt.c, which writes the counts of
+//  every path that ran to $ISPRE_PATHS_FILE. With -ispre-path-profile=<file>, the ISPRE
+//  passes build the hot region from the hottest paths instead of thresholding every block and
+//  edge on its own, so two edges that are hot but never run on the same path stay apart.
+//
+////===----------------------------------------------------------------------===//
+#include "PathProfile.h"
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/CFG.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/DerivedTypes.h"
+#include "llvm/IR/GlobalVariable.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Transforms/Utils/BasicBlockUtils.h"
+#include "llvm/Transforms/Utils/ModuleUtils.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <string>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "ispre-path-profile-gen"
+
+STATISTIC(NumPathFunctions, "Number of functions instrumented for path profiling");
+STATISTIC(NumPathsNumbered, "Number of acyclic paths in the instrumented functions");
+STATISTIC(NumPathSkipped, "Number of functions with too many paths to instrument");
+
+static cl::opt<uint64_t> MaxPaths("ispre-path-max",
+                                  cl::desc("Leave functions with more acyclic paths than this "
+                                           "uninstrumented (one 8-byte counter per path)"),
+                                  cl::init(4096));
+
+PathNumbering numberPaths(Function &F, uint64_t maxPaths) {
+    PathNumbering numbering;
+    // Code on an edge into an EH pad or out of an indirectbr or callbr has nowhere to go: such
+    // edges cannot be split
+    for (BasicBlock &BB : F) {
+        if (BB.isEHPad() || isa<IndirectBrInst>(BB.getTerminator()) ||
+            isa<CallBrInst>(BB.getTerminator())) {
+            return numbering;
+        }
+    }
+
+    // Iterative depth-first search: an edge to a block still on the stack is a back edge, and
+    // the reverse postorder of the other edges is a topological order of the path DAG
+    BasicBlock *entry = &F.getEntryBlock();
+    std::map<BasicBlock *, std::vector<BasicBlock *>> successorsOf;
+    std::set<BasicBlock *> visited{entry};
+    std::set<BasicBlock *> onStack{entry};
+    std::vector<BasicBlock *> postorder;
+    std::vector<std::pair<BasicBlock *, size_t>> stack{{entry, 0}};
+    while (!stack.empty()) {
+        BasicBlock *BB = stack.back().first;
+        std::vector<BasicBlock *> &succs = successorsOf[BB];
+        if (stack.back().second == 0 && succs.empty()) {
+            // Cases of a switch that share a target are one edge
+            for (BasicBlock *successor : successors(BB)) {
+                if (std::find(succs.begin(), succs.end(), successor) == succs.end()) {
+                    succs.push_back(successor);
+                }
+            }
+        }
+        if (stack.back().second == succs.size()) {
+            postorder.push_back(BB);
+            onStack.erase(BB);
+            stack.pop_back();
+            continue;
+        }
+        BasicBlock *successor = succs[stack.back().second++];
+        if (onStack.count(successor)) {
+            numbering.backEdges.push_back({BB, successor});
+        } else if (visited.insert(successor).second) {
+            onStack.insert(successor);
+            stack.push_back({successor, 0});
+        }
+    }
+
+    std::set<std::pair<BasicBlock *, BasicBlock *>> back(numbering.backEdges.begin(),
+                                                         numbering.backEdges.end());
+    auto outEdges = [&](BasicBlock *BB) {
+        std::vector<PathNumbering::Edge> edges;
+        if (!BB) {
+            edges.push_back({PathNumbering::Start, nullptr, entry, nullptr, nullptr, 0});
+            for (auto &edge : numbering.backEdges) {
+                edges.push_back(
+                    {PathNumbering::LoopEntry, nullptr, edge.second, edge.first, edge.second, 0});
+            }
+            return edges;
+        }
+        for (BasicBlock *successor : successorsOf[BB]) {
+            if (back.count({BB, successor})) {
+                edges.push_back({PathNumbering::LoopExit, BB, nullptr, BB, successor, 0});
+            } else {
+                edges.push_back({PathNumbering::Real, BB, successor, nullptr, nullptr, 0});
+            }
+        }
+        if (successorsOf[BB].empty()) {
+            edges.push_back({PathNumbering::Exit, BB, nullptr, nullptr, nullptr, 0});
+        }
+        return edges;
+    };
+
+    // Paths from every block to the exit node, in reverse topological order
+    std::map<BasicBlock *, uint64_t> pathsFrom;
+    postorder.push_back(nullptr);
+    for (BasicBlock *BB : postorder) {
+        std::vector<PathNumbering::Edge> edges = outEdges(BB);
+        uint64_t paths = 0;
+        for (PathNumbering::Edge &edge : edges) {
+            edge.value = paths;
+            uint64_t through = edge.to ? pathsFrom[edge.to] : 1;
+            if (through > maxPaths - paths) {
+                return numbering;
+            }
+            paths += through;
+        }
+        pathsFrom[BB] = paths;
+        numbering.out[BB] = std::move(edges);
+    }
+    numbering.numPaths = pathsFrom[nullptr];
+    numbering.valid = true;
+    return numbering;
+}
+
+namespace {
+struct FunctionPaths {
+    uint64_t numPaths = 0;
+    std::map<uint64_t, uint64_t> counts;
+};
+
+// Path counts of every file read so far; every ISPRE pass of a pipeline reads the same one
+std::map<std::string, std::map<std::string, FunctionPaths>> LoadedPathProfiles;
+
+const std::map<std::string, FunctionPaths> &loadPathProfile(StringRef path) {
+    auto loaded = LoadedPathProfiles.find(path.str());
+    if (loaded != LoadedPathProfiles.end()) {
+        return loaded->second;
+    }
+    std::map<std::string, FunctionPaths> &functions = LoadedPathProfiles[path.str()];
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(path);
+    if (!buffer) {
+        WithColor::error() << path << ": " << buffer.getError().message() << "\n";
+        return functions;
+    }
+    // function, paths, path, count; the first line is the header
+    SmallVector<StringRef, 0> lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, false);
+    for (size_t i = 1; i < lines.size(); i++) {
+        SmallVector<StringRef, 4> fields;
+        lines[i].split(fields, '\t');
+        uint64_t numPaths, number, count;
+        if (fields.size() != 4 || fields[1].getAsInteger(10, numPaths) ||
+            fields[2].getAsInteger(10, number) || fields[3].getAsInteger(10, count)) {
+            WithColor::warning() << path << ":" << i + 1 << ": malformed line\n";
+            continue;
+        }
+        FunctionPaths &paths = functions[fields[0].str()];
+        paths.numPaths = numPaths;
+        paths.counts[number] += count;
+    }
+    return functions;
+}
+} // namespace
+
+bool getHotPathRegion(Function &F, StringRef path, double threshold,
+                      std::set<BasicBlock *> &blocks,
+                      std::set<std::pair<BasicBlock *, BasicBlock *>> &edges) {
+    const std::map<std::string, FunctionPaths> &functions = loadPathProfile(path);
+    auto recorded = functions.find(F.getName().str());
+    if (recorded == functions.end()) {
+        return false;
+    }
+    PathNumbering numbering = numberPaths(F, std::numeric_limits<uint64_t>::max());
+    if (!numbering.valid || numbering.numPaths != recorded->second.numPaths) {
+        return false;
+    }
+
+    uint64_t maxCount = 0;
+    for (auto &entry : recorded->second.counts) {
+        maxCount = std::max(maxCount, entry.second);
+    }
+    for (auto &entry : recorded->second.counts) {
+        if (entry.first >= numbering.numPaths || !maxCount ||
+            (double)entry.second / (double)maxCount <= threshold) {
+            continue;
+        }
+        // Follow the edge with the largest value that fits in what is left of the number
+        uint64_t left = entry.first;
+        BasicBlock *node = nullptr;
+        do {
+            const std::vector<PathNumbering::Edge> &out = numbering.out[node];
+            auto edge = std::prev(std::upper_bound(
+                out.begin(), out.end(), left,
+                [](uint64_t value, const PathNumbering::Edge &e) { return value < e.value; }));
+            left -= edge->value;
+            if (edge->kind == PathNumbering::Real) {
+                edges.insert({edge->from, edge->to});
+            } else if (edge->kind == PathNumbering::LoopExit) {
+                edges.insert({edge->backFrom, edge->backTo});
+            }
+            node = edge->to;
+            if (node) {
+                blocks.insert(node);
+            }
+        } while (node);
+    }
+    return true;
+}
+
+namespace {
+struct PathProfileGenPass : public ModulePass {
+    static char ID;
+
+    PathProfileGenPass() : ModulePass(ID) {}
+
+    // Where code on the edge from -> to goes; the edge is split if it is critical. Cases of a
+    // switch that share a target are one edge, so all of them are sent through the new block.
+    Instruction *edgeInsertPoint(BasicBlock *from, BasicBlock *to) {
+        if (from->getSingleSuccessor()) {
+            return from->getTerminator();
+        }
+        if (to->getUniquePredecessor()) {
+            return &*to->getFirstInsertionPt();
+        }
+        BasicBlock *split =
+            SplitCriticalEdge(from->getTerminator(), GetSuccessorNumber(from, to),
+                              CriticalEdgeSplittingOptions().setMergeIdenticalEdges());
+        return split->getTerminator();
+    }
+
+    // Record of F, laid out as struct ispre_path_table in runtime/ispre_rt.c; the runtime
+    // finds every record through the ispre_paths section
+    GlobalVariable *createTable(Function &F, uint64_t numPaths) {
+        Module &M = *F.getParent();
+        LLVMContext &ctx = F.getContext();
+        Type *i64Ty = Type::getInt64Ty(ctx);
+        StructType *tableTy = StructType::getTypeByName(ctx, "struct.ispre_path_table");
+        if (!tableTy) {
+            tableTy = StructType::create(
+                ctx, {Type::getInt8PtrTy(ctx), i64Ty, PointerType::getUnqual(i64Ty)},
+                "struct.ispre_path_table");
+        }
+
+        if (!M.getNamedGlobal("__ispre_runtime_user")) {
+            // Referencing the runtime's hook pulls ispre_rt.o out of libispre_rt.a
+            Constant *hook = M.getOrInsertGlobal("__ispre_runtime", Type::getInt32Ty(ctx));
+            GlobalVariable *user =
+                new GlobalVariable(M, hook->getType(), true, GlobalValue::LinkOnceODRLinkage, hook,
+                                   "__ispre_runtime_user");
+            user->setVisibility(GlobalValue::HiddenVisibility);
+            appendToCompilerUsed(M, {user});
+        }
+
+        ArrayType *countsTy = ArrayType::get(i64Ty, numPaths);
+        GlobalVariable *counts =
+            new GlobalVariable(M, countsTy, false, GlobalValue::PrivateLinkage,
+                               ConstantAggregateZero::get(countsTy), "__ispre_path_counts");
+        IRBuilder<> IRB(ctx);
+        Constant *init = ConstantStruct::get(
+            tableTy, {IRB.CreateGlobalStringPtr(F.getName(), "", 0, &M),
+                      ConstantInt::get(i64Ty, numPaths),
+                      ConstantExpr::getBitCast(counts, PointerType::getUnqual(i64Ty))});
+        GlobalVariable *table = new GlobalVariable(M, tableTy, false, GlobalValue::PrivateLinkage,
+                                                   init, "__ispre_path_table");
+        table->setSection("ispre_paths");
+        table->setAlignment(Align(8));
+        appendToCompilerUsed(M, {table});
+        return counts;
+    }
+
+    void countPath(GlobalVariable *counts, AllocaInst *pathReg, uint64_t value,
+                   Instruction *insertBefore) {
+        IRBuilder<> IRB(insertBefore);
+        Value *number = IRB.CreateAdd(IRB.CreateLoad(IRB.getInt64Ty(), pathReg),
+                                      IRB.getInt64(value));
+        Value *addr = IRB.CreateInBoundsGEP(counts->getValueType(), counts,
+                                            {IRB.getInt64(0), number});
+        Value *count = IRB.CreateLoad(IRB.getInt64Ty(), addr);
+        IRB.CreateStore(IRB.CreateAdd(count, IRB.getInt64(1)), addr);
+    }
+
+    bool instrument(Function &F) {
+        PathNumbering numbering = numberPaths(F, MaxPaths);
+        if (!numbering.valid) {
+            ++NumPathSkipped;
+            return false;
+        }
+
+        // Insertion points are all found before any code is inserted. Splitting an edge only
+        // redirects that edge, so the points found for the others stay where they were.
+        std::vector<std::pair<PathNumbering::Edge, Instruction *>> work;
+        for (auto &entry : numbering.out) {
+            for (const PathNumbering::Edge &edge : entry.second) {
+                if (edge.kind == PathNumbering::Real && edge.value != 0) {
+                    work.push_back({edge, nullptr});
+                } else if (edge.kind == PathNumbering::Exit ||
+                           edge.kind == PathNumbering::LoopExit) {
+                    work.push_back({edge, nullptr});
+                }
+            }
+        }
+        size_t numBlocks = F.size();
+        for (auto &item : work) {
+            const PathNumbering::Edge &edge = item.first;
+            if (edge.kind == PathNumbering::Real) {
+                item.second = edgeInsertPoint(edge.from, edge.to);
+            } else if (edge.kind == PathNumbering::LoopExit) {
+                item.second = edgeInsertPoint(edge.backFrom, edge.backTo);
+            } else {
+                item.second = edge.from->getTerminator();
+            }
+            // numberPaths rejects the terminators whose edges cannot be split; should one
+            // still fail, the function is left uninstrumented rather than miscounted
+            if (!item.second) {
+                ++NumPathSkipped;
+                OptimizationRemarkEmitter ORE(&F);
+                ORE.emit([&]() {
+                    return OptimizationRemarkMissed(DEBUG_TYPE, "UnsplittableEdge",
+                                                    edge.from->getTerminator())
+                           << "function " << ore::NV("Function", F.getName())
+                           << " not path profiled: the edge from "
+                           << ore::NV("From", edge.from->getName()) << " cannot be split";
+                });
+                return F.size() != numBlocks;
+            }
+        }
+
+        ++NumPathFunctions;
+        NumPathsNumbered += numbering.numPaths;
+        GlobalVariable *counts = createTable(F, numbering.numPaths);
+
+        IRBuilder<> IRB(&*F.getEntryBlock().getFirstInsertionPt());
+        AllocaInst *pathReg = IRB.CreateAlloca(IRB.getInt64Ty(), nullptr, "ispre.path");
+        IRB.CreateStore(IRB.getInt64(0), pathReg);
+
+        // The value that starts a path at each loop header, by back edge
+        std::map<std::pair<BasicBlock *, BasicBlock *>, uint64_t> restart;
+        for (const PathNumbering::Edge &edge : numbering.out[nullptr]) {
+            if (edge.kind == PathNumbering::LoopEntry) {
+                restart[{edge.backFrom, edge.backTo}] = edge.value;
+            }
+        }
+        for (auto &item : work) {
+            const PathNumbering::Edge &edge = item.first;
+            IRBuilder<> IRB(item.second);
+            if (edge.kind == PathNumbering::Real) {
+                Value *number = IRB.CreateLoad(IRB.getInt64Ty(), pathReg);
+                IRB.CreateStore(IRB.CreateAdd(number, IRB.getInt64(edge.value)), pathReg);
+                continue;
+            }
+            countPath(counts, pathReg, edge.value, item.second);
+            if (edge.kind == PathNumbering::LoopExit) {
+                IRB.CreateStore(IRB.getInt64(restart[{edge.backFrom, edge.backTo}]), pathReg);
+            }
+        }
+        return true;
+    }
+
+    bool runOnModule(Module &M) override {
+        bool changed = false;
+        for (Function &F : M) {
+            if (!F.isDeclaration()) {
+                changed |= instrument(F);
+            }
+        }
+        return changed;
+    }
+};
+} // namespace
+
+char PathProfileGenPass::ID = 0;
+static RegisterPass<PathProfileGenPass>
+    X("ispre-path-profile-gen", "Ball-Larus path profiling for the ISPRE passes", false, false);
@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//  Ball-Larus path numbering shared by path profiling and the ISPRE passes
+//
+////===----------------------------------------------------------------------===//
+#ifndef ISPRE_PATHPROFILE_H
+#define ISPRE_PATHPROFILE_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+// Ball-Larus numbering of the acyclic paths of a function. Every back edge from -> to is
+// replaced by a pseudo edge from the entry node to `to` and one from `from` to the exit node,
+// so every path starts at the function entry or a loop header and ends at a return or a back
+// edge. Summing the values of the edges along a path gives its number in [0, numPaths).
+struct PathNumbering {
+    enum EdgeKind { Start, Real, Exit, LoopEntry, LoopExit };
+    struct Edge {
+        EdgeKind kind;
+        // From is null for the edges of the entry node, to for the edges to the exit node
+        llvm::BasicBlock *from;
+        llvm::BasicBlock *to;
+        // The back edge that a LoopEntry or LoopExit edge replaces
+        llvm::BasicBlock *backFrom;
+        llvm::BasicBlock *backTo;
+        uint64_t value;
+    };
+    // Outgoing edges of every block in increasing value order; the entry node is null
+    std::map<llvm::BasicBlock *, std::vector<Edge>> out;
+    std::vector<std::pair<llvm::BasicBlock *, llvm::BasicBlock *>> backEdges;
+    uint64_t numPaths = 0;
+    // False if the function has more than maxPaths paths, exception handling edges, or an
+    // indirectbr or callbr
+    bool valid = false;
+};
+
+PathNumbering numberPaths(llvm::Function &F, uint64_t maxPaths);
+
+// Blocks and edges (back edges included) of the paths of F that ran more than threshold times
+// as often as its hottest path, according to the path counts in the file written by the
+// runtime. False if the file has no counts for F, or counts for a different CFG.
+bool getHotPathRegion(llvm::Function &F, llvm::StringRef path, double threshold,
+                      std::set<llvm::BasicBlock *> &blocks,
+                      std::set<std::pair<llvm::BasicBlock *, llvm::BasicBlock *>> &edges);
+
+#endif // ISPRE_PATHPROFILE_H
@@ -0,0 +1,8 @@
+//===----------------------------------------------------------------------===//
+//
+//  Hook for observing the phases of the ISPRE passes in process
+//
+////===----------------------------------------------------------------------===//
+#include "PhaseObserver.h"
+
+PhaseObserverFn PhaseObserver = nullptr;
@@ -0,0 +1,16 @@
+//===----------------------------------------------------------------------===//
+//
+//  Hook for observing the phases of the ISPRE passes in process
+//
+////===----------------------------------------------------------------------===//
+#ifndef ISPRE_PHASEOBSERVER_H
+#define ISPRE_PHASEOBSERVER_H
+
+#include "llvm/ADT/StringRef.h"
+
+// Called with start = true when a phase begins and start = false when it ends. Tools that link
+// the passes directly (such as the phase benchmarks) set it; opt never does.
+using PhaseObserverFn = void (*)(llvm::StringRef pass, llvm::StringRef phase, bool start);
+extern PhaseObserverFn PhaseObserver;
+
+#endif // ISPRE_PHASEOBSERVER_H
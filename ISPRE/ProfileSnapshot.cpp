@@ -0,0 +1,123 @@
+//===----------------------------------------------------------------------===//
+//
+//  Block count snapshots read and written by the ISPRE profile passes
+//
+////===----------------------------------------------------------------------===//
+#include "ProfileSnapshot.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/DebugInfoMetadata.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/InstrTypes.h"
+#include "llvm/IR/IntrinsicInst.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/xxhash.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <limits>
+
+using namespace llvm;
+
+static int64_t jsonCount(uint64_t count) {
+    return (int64_t)std::min<uint64_t>(count, std::numeric_limits<int64_t>::max());
+}
+
+SnapshotBlock getBlockShape(BasicBlock &BB) {
+    DISubprogram *SP = BB.getParent()->getSubprogram();
+    int firstLine = SP ? SP->getLine() : 0;
+    std::string text;
+    raw_string_ostream os(text);
+    std::set<std::string> anchors;
+    for (Instruction &I : BB) {
+        if (isa<DbgInfoIntrinsic>(I)) {
+            continue;
+        }
+        os << I.getOpcodeName() << ";";
+        if (auto *call = dyn_cast<CallBase>(&I)) {
+            if (Function *callee = call->getCalledFunction()) {
+                os << callee->getName() << ";";
+                anchors.insert(("call:" + callee->getName()).str());
+            }
+        }
+        if (const DebugLoc &loc = I.getDebugLoc()) {
+            anchors.insert("line:" + std::to_string((int)loc.getLine() - firstLine));
+        }
+    }
+    os << BB.getTerminator()->getNumSuccessors();
+    return {xxHash64(os.str()), anchors};
+}
+
+json::Value recordFunction(Function &F) {
+    DominatorTree DT(F);
+    LoopInfo LI(DT);
+    BranchProbabilityInfo BPI(F, LI);
+    BlockFrequencyInfo BFI(F, BPI, LI);
+    json::Array blocks;
+    for (BasicBlock &BB : F) {
+        SnapshotBlock shape = getBlockShape(BB);
+        uint64_t count = BFI.getBlockProfileCount(&BB).getValueOr(0);
+        json::Array edges;
+        for (BasicBlock *successor : successors(&BB)) {
+            edges.push_back(jsonCount(BPI.getEdgeProbability(&BB, successor).scale(count)));
+        }
+        blocks.push_back(json::Object{{"hash", utohexstr(shape.hash)},
+                                      {"count", jsonCount(count)},
+                                      {"edges", std::move(edges)},
+                                      {"anchors", json::Array(shape.anchors)}});
+    }
+    return json::Object{{"name", F.getName()}, {"blocks", std::move(blocks)}};
+}
+
+bool readProfileSnapshot(StringRef path, ProfileSnapshot &snapshot) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(path);
+    if (!buffer) {
+        WithColor::error() << path << ": " << buffer.getError().message() << "\n";
+        return false;
+    }
+    Expected<json::Value> root = json::parse((*buffer)->getBuffer());
+    if (!root) {
+        WithColor::error() << path << ": " << toString(root.takeError()) << "\n";
+        return false;
+    }
+    const json::Object *object = root->getAsObject();
+    const json::Array *functions = object ? object->getArray("functions") : nullptr;
+    if (!functions) {
+        WithColor::error() << path << ": not an ISPRE profile snapshot\n";
+        return false;
+    }
+    for (const json::Value &value : *functions) {
+        const json::Object *function = value.getAsObject();
+        const json::Array *blocks = function ? function->getArray("blocks") : nullptr;
+        if (!blocks) {
+            continue;
+        }
+        std::vector<SnapshotBlock> &shapes =
+            snapshot[function->getString("name").getValueOr("").str()];
+        for (const json::Value &entry : *blocks) {
+            const json::Object *block = entry.getAsObject();
+            if (!block) {
+                continue;
+            }
+            SnapshotBlock shape{0, {}, (uint64_t)block->getInteger("count").getValueOr(0)};
+            block->getString("hash").getValueOr("0").getAsInteger(16, shape.hash);
+            if (const json::Array *anchors = block->getArray("anchors")) {
+                for (const json::Value &anchor : *anchors) {
+                    shape.anchors.insert(anchor.getAsString().getValueOr("").str());
+                }
+            }
+            if (const json::Array *edges = block->getArray("edges")) {
+                for (const json::Value &edge : *edges) {
+                    shape.edges.push_back((uint64_t)edge.getAsInteger().getValueOr(0));
+                }
+            }
+            shapes.push_back(std::move(shape));
+        }
+    }
+    return true;
+}
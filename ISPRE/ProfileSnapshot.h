@@ -0,0 +1,43 @@
+//===----------------------------------------------------------------------===//
+//
+//  Block count snapshots read and written by the ISPRE profile passes
+//
+////===----------------------------------------------------------------------===//
+#ifndef ISPRE_PROFILESNAPSHOT_H
+#define ISPRE_PROFILESNAPSHOT_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/Support/JSON.h"
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// One block of a snapshot. The hash covers the opcodes, the callees and the number of
+// successors, so it survives edits that only move code; the anchors (callees and source lines
+// relative to the function) let a block that changed be matched by what it calls and where it
+// sits. Edges holds the count of every successor edge, in successor order.
+struct SnapshotBlock {
+    uint64_t hash;
+    std::set<std::string> anchors;
+    uint64_t count = 0;
+    std::vector<uint64_t> edges;
+};
+
+// Recorded blocks of every function, in layout order
+using ProfileSnapshot = std::map<std::string, std::vector<SnapshotBlock>>;
+
+// Hash and anchors of a block, without counts
+SnapshotBlock getBlockShape(llvm::BasicBlock &BB);
+
+// Snapshot of the profile counts of F, as written to the "functions" array
+llvm::json::Value recordFunction(llvm::Function &F);
+
+// Read a snapshot file; reports the error and returns false if it cannot be read
+bool readProfileSnapshot(llvm::StringRef path, ProfileSnapshot &snapshot);
+
+#endif // ISPRE_PROFILESNAPSHOT_H
@@ -0,0 +1,349 @@
+//===----------------------------------------------------------------------===//
+//
+//  Stale profile recovery for the ISPRE passes
+//
+//  -pgo-instr-use drops the counts of every function whose CFG changed since the profile was
+//  collected. With -ispre-profile-snapshot-out, this pass records the block counts of every
+//  profiled function, with a structural hash and the anchors (callees and source lines
+//  relative to the function) of each block. With -ispre-profile-snapshot, it matches the
+//  blocks of functions left without a profile to the recorded ones, fills in the blocks it
+//  could not match from their neighbours, and writes the counts back as an entry count and
+//  branch weights, so that the ISPRE passes after it classify the function again. A matched
+//  branch keeps its recorded edge counts; the other branches get weights that conserve the
+//  flow into their successors.
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/ADT/Statistic.h"
+#include "llvm/Analysis/OptimizationRemarkEmitter.h"
+#include "llvm/IR/CFG.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "ProfileSnapshot.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "ispre-stale-profile"
+
+STATISTIC(NumRecovered, "Number of functions whose stale profile was recovered");
+STATISTIC(NumUnrecovered, "Number of functions with too few matching blocks to recover");
+STATISTIC(NumMatchedBlocks, "Number of blocks matched to a recorded block");
+STATISTIC(NumInferredBlocks, "Number of blocks whose count was inferred from their neighbours");
+
+static cl::opt<std::string> SnapshotOut("ispre-profile-snapshot-out",
+                                        cl::desc("Record the block counts of every profiled "
+                                                 "function into this file"),
+                                        cl::value_desc("file"));
+
+static cl::opt<std::string> SnapshotIn("ispre-profile-snapshot",
+                                       cl::desc("Recover functions without a profile from the "
+                                                "block counts recorded in this file"),
+                                       cl::value_desc("file"));
+
+static cl::opt<double> MinMatch("ispre-stale-min-match",
+                                cl::desc("Smallest fraction of blocks that must match a recorded "
+                                         "block for a function to be recovered"),
+                                cl::init(0.5));
+
+namespace {
+double similarity(const std::set<std::string> &a, const std::set<std::string> &b) {
+    if (a.empty() || b.empty()) {
+        return 0;
+    }
+    size_t common = 0;
+    for (const std::string &anchor : a) {
+        common += b.count(anchor);
+    }
+    return (double)common / (a.size() + b.size() - common);
+}
+
+// Recorded counts of the successor edges of the matched blocks that kept their successors
+using EdgeCounts = std::map<BasicBlock *, std::vector<uint64_t>>;
+
+struct StaleProfilePass : public ModulePass {
+    static char ID;
+    ProfileSnapshot Recorded;
+
+    StaleProfilePass() : ModulePass(ID) {}
+
+    // Match the blocks of F to its recorded blocks: first the hashes that occur once on both
+    // sides, then the remaining hashes in layout order, then the most similar anchors. Returns
+    // the index of the recorded block of every block.
+    std::vector<Optional<size_t>> match(Function &F, const std::vector<SnapshotBlock> &old) {
+        std::vector<SnapshotBlock> current;
+        for (BasicBlock &BB : F) {
+            current.push_back(getBlockShape(BB));
+        }
+        std::vector<Optional<size_t>> matches(current.size());
+        std::vector<bool> used(old.size());
+
+        std::map<uint64_t, std::vector<size_t>> oldByHash, currentByHash;
+        for (size_t i = 0; i < old.size(); i++) {
+            oldByHash[old[i].hash].push_back(i);
+        }
+        for (size_t i = 0; i < current.size(); i++) {
+            currentByHash[current[i].hash].push_back(i);
+        }
+        for (bool uniqueOnly : {true, false}) {
+            for (auto &group : currentByHash) {
+                std::vector<size_t> &candidates = oldByHash[group.first];
+                if (uniqueOnly && (group.second.size() != 1 || candidates.size() != 1)) {
+                    continue;
+                }
+                size_t next = 0;
+                for (size_t i : group.second) {
+                    while (next < candidates.size() && used[candidates[next]]) {
+                        next++;
+                    }
+                    if (matches[i] || next == candidates.size()) {
+                        continue;
+                    }
+                    matches[i] = candidates[next];
+                    used[candidates[next]] = true;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < current.size(); i++) {
+            if (matches[i]) {
+                continue;
+            }
+            double best = 0.5;
+            size_t bestOld = old.size();
+            for (size_t j = 0; j < old.size(); j++) {
+                double score = used[j] ? 0 : similarity(current[i].anchors, old[j].anchors);
+                if (score >= best) {
+                    best = score;
+                    bestOld = j;
+                }
+            }
+            if (bestOld != old.size()) {
+                matches[i] = bestOld;
+                used[bestOld] = true;
+            }
+        }
+        return matches;
+    }
+
+    // Count of the edges from pred to BB, if pred's recorded edge counts are known
+    Optional<uint64_t> getEdgeCount(BasicBlock *pred, BasicBlock *BB, const EdgeCounts &edges) {
+        auto known = edges.find(pred);
+        if (known == edges.end()) {
+            return None;
+        }
+        uint64_t count = 0;
+        Instruction *terminator = pred->getTerminator();
+        for (unsigned i = 0; i < terminator->getNumSuccessors(); i++) {
+            if (terminator->getSuccessor(i) == BB) {
+                count += known->second[i];
+            }
+        }
+        return count;
+    }
+
+    // Give unmatched blocks the count of a straight-line neighbour, or the sum of their incoming
+    // edges when all of them were recorded, and 0 if neither is known
+    void infer(Function &F, std::vector<Optional<uint64_t>> &counts,
+               std::map<BasicBlock *, size_t> &index, const EdgeCounts &edges) {
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (BasicBlock &BB : F) {
+                Optional<uint64_t> &count = counts[index[&BB]];
+                if (count) {
+                    continue;
+                }
+                BasicBlock *pred = BB.getSinglePredecessor();
+                BasicBlock *succ = BB.getSingleSuccessor();
+                if (pred && pred->getSingleSuccessor() == &BB && counts[index[pred]]) {
+                    count = counts[index[pred]];
+                } else if (succ && succ->getSinglePredecessor() == &BB && counts[index[succ]]) {
+                    count = counts[index[succ]];
+                } else if (Optional<uint64_t> incoming = getIncomingCount(&BB, edges)) {
+                    count = incoming;
+                } else {
+                    continue;
+                }
+                ++NumInferredBlocks;
+                changed = true;
+            }
+        }
+        for (Optional<uint64_t> &count : counts) {
+            if (!count) {
+                count = 0;
+            }
+        }
+    }
+
+    // Sum of the edges into BB, if every predecessor's recorded edge counts are known
+    Optional<uint64_t> getIncomingCount(BasicBlock *BB, const EdgeCounts &edges) {
+        if (pred_empty(BB)) {
+            return None;
+        }
+        uint64_t count = 0;
+        std::set<BasicBlock *> seen;
+        for (BasicBlock *pred : predecessors(BB)) {
+            if (!seen.insert(pred).second) {
+                continue;
+            }
+            Optional<uint64_t> edge = getEdgeCount(pred, BB, edges);
+            if (!edge) {
+                return None;
+            }
+            count += *edge;
+        }
+        return count;
+    }
+
+    // Estimate of the edge from BB into target when BB's edges were not recorded: what is left
+    // of the target's count after its recorded incoming edges, shared evenly among the others
+    uint64_t inferEdgeCount(BasicBlock *target, uint64_t count, const EdgeCounts &edges) {
+        uint64_t recorded = 0;
+        unsigned unknown = 0;
+        std::set<BasicBlock *> seen;
+        for (BasicBlock *pred : predecessors(target)) {
+            if (edges.count(pred)) {
+                if (seen.insert(pred).second) {
+                    recorded += *getEdgeCount(pred, target, edges);
+                }
+            } else {
+                unknown++;
+            }
+        }
+        return count > recorded ? (count - recorded) / std::max(unknown, 1u) : 0;
+    }
+
+    // Write the counts back as the entry count and the branch weights of every branch. A
+    // branch of a matched block that kept its successors is weighted by its recorded edges.
+    void annotate(Function &F, std::vector<Optional<uint64_t>> &counts,
+                  std::map<BasicBlock *, size_t> &index, const EdgeCounts &edges) {
+        F.setEntryCount(Function::ProfileCount(*counts[0], Function::PCT_Real));
+        MDBuilder MDB(F.getContext());
+        for (BasicBlock &BB : F) {
+            Instruction *terminator = BB.getTerminator();
+            if (terminator->getNumSuccessors() < 2) {
+                continue;
+            }
+            std::vector<uint64_t> weights;
+            auto known = edges.find(&BB);
+            if (known != edges.end()) {
+                weights = known->second;
+            } else {
+                // No edge carries more than its source executes
+                for (BasicBlock *successor : successors(&BB)) {
+                    weights.push_back(
+                        std::min(inferEdgeCount(successor, *counts[index[successor]], edges),
+                                 *counts[index[&BB]]));
+                }
+            }
+            uint64_t max = *std::max_element(weights.begin(), weights.end());
+            if (max == 0) {
+                continue;
+            }
+            // Branch weights are 32-bit
+            uint64_t scale = max / std::numeric_limits<uint32_t>::max() + 1;
+            std::vector<uint32_t> scaled;
+            for (uint64_t weight : weights) {
+                scaled.push_back((uint32_t)(weight / scale));
+            }
+            terminator->setMetadata(LLVMContext::MD_prof, MDB.createBranchWeights(scaled));
+        }
+    }
+
+    void recover(Function &F, const std::vector<SnapshotBlock> &old) {
+        OptimizationRemarkEmitter ORE(&F);
+        std::vector<Optional<size_t>> matches = match(F, old);
+        std::vector<Optional<uint64_t>> counts(matches.size());
+        EdgeCounts edges;
+        size_t i = 0;
+        for (BasicBlock &BB : F) {
+            if (Optional<size_t> j = matches[i]) {
+                counts[i] = old[*j].count;
+                if (old[*j].edges.size() == BB.getTerminator()->getNumSuccessors()) {
+                    edges[&BB] = old[*j].edges;
+                }
+            }
+            i++;
+        }
+        size_t matched = std::count_if(counts.begin(), counts.end(),
+                                       [](const Optional<uint64_t> &c) { return c.hasValue(); });
+        if (matched < MinMatch * counts.size()) {
+            ++NumUnrecovered;
+            ORE.emit([&]() {
+                return OptimizationRemarkMissed(DEBUG_TYPE, "StaleProfileUnmatched",
+                                                F.getSubprogram(), &F.getEntryBlock())
+                       << "stale profile of " << ore::NV("Function", F.getName())
+                       << " not recovered: " << ore::NV("Matched", (unsigned)matched) << " of "
+                       << ore::NV("Blocks", (unsigned)counts.size()) << " blocks matched";
+            });
+            return;
+        }
+        NumMatchedBlocks += matched;
+
+        std::map<BasicBlock *, size_t> index;
+        for (BasicBlock &BB : F) {
+            index[&BB] = index.size();
+        }
+        infer(F, counts, index, edges);
+        annotate(F, counts, index, edges);
+        ++NumRecovered;
+        ORE.emit([&]() {
+            return OptimizationRemarkAnalysis(DEBUG_TYPE, "StaleProfileRecovered",
+                                              F.getSubprogram(), &F.getEntryBlock())
+                   << "recovered the stale profile of " << ore::NV("Function", F.getName())
+                   << ": " << ore::NV("Matched", (unsigned)matched) << " of "
+                   << ore::NV("Blocks", (unsigned)counts.size())
+                   << " blocks matched, entry count " << ore::NV("EntryCount", *counts[0]);
+        });
+    }
+
+    bool runOnModule(Module &M) override {
+        if (!SnapshotOut.empty()) {
+            json::Array functions;
+            for (Function &F : M) {
+                if (!F.isDeclaration() && F.hasProfileData()) {
+                    functions.push_back(recordFunction(F));
+                }
+            }
+            std::error_code EC;
+            raw_fd_ostream out(SnapshotOut, EC, sys::fs::OF_Text);
+            if (EC) {
+                WithColor::error() << SnapshotOut << ": " << EC.message() << "\n";
+            } else {
+                out << json::Value(json::Object{{"functions", std::move(functions)}}) << "\n";
+            }
+        }
+
+        if (SnapshotIn.empty() || !readProfileSnapshot(SnapshotIn, Recorded)) {
+            return false;
+        }
+        bool changed = false;
+        for (Function &F : M) {
+            auto old = Recorded.find(F.getName().str());
+            if (F.isDeclaration() || F.hasProfileData() || old == Recorded.end()) {
+                continue;
+            }
+            recover(F, old->second);
+            changed |= F.hasProfileData();
+        }
+        return changed;
+    }
+};
+} // namespace
+
+char StaleProfilePass::ID = 0;
+static RegisterPass<StaleProfilePass>
+    X("ispre-stale-profile", "Recover stale profiles for the ISPRE passes", false, false);
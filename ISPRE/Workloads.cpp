@@ -0,0 +1,152 @@
+//===----------------------------------------------------------------------===//
+//
+//  Per-workload hotness for the ISPRE passes
+//
+//  A merged profile (llvm-profdata merge -weighted-input) gives the weighted mix of several
+//  workloads, but a block can be hot in the mix while it is cold under most of them. The
+//  -ispre-workloads pass reads one block count snapshot per workload (written by
+//  -ispre-profile-snapshot-out from that workload's profile) and attaches to every terminator
+//  the count of its block and of each successor edge relative to the hottest block of the
+//  function under every workload, as !ispre.workloads metadata:
+//
+//    !{!{double weight, double block, double edge0, double edge1, ...}, ...}
+//
+//  The ISPRE passes then only treat a block or edge as hot if it is hot under a quorum of the
+//  workload weight (-ispre-workload-quorum).
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/ADT/Statistic.h"
+#include "llvm/IR/Constants.h"
+#include "llvm/IR/Metadata.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Type.h"
+#include "llvm/Pass.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/WithColor.h"
+
+#include "ProfileSnapshot.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+#define DEBUG_TYPE "ispre-workloads"
+
+STATISTIC(NumAnnotated, "Number of functions annotated with per-workload counts");
+STATISTIC(NumMismatched, "Number of function snapshots that do not match the function");
+
+static cl::list<std::string>
+    WorkloadProfiles("ispre-workload-profile",
+                     cl::desc("Block count snapshot of one workload, optionally weighted "
+                              "(default weight 1)"),
+                     cl::value_desc("snapshot[:weight]"));
+
+namespace {
+struct Workload {
+    double weight;
+    ProfileSnapshot snapshot;
+};
+
+struct WorkloadsPass : public ModulePass {
+    static char ID;
+
+    WorkloadsPass() : ModulePass(ID) {}
+
+    bool readWorkloads(std::vector<Workload> &workloads) {
+        for (StringRef spec : WorkloadProfiles) {
+            auto parts = spec.rsplit(':');
+            Workload workload{1, {}};
+            if (!parts.second.empty() && parts.second.getAsDouble(workload.weight)) {
+                WithColor::error() << spec << ": the weight is not a number\n";
+                return false;
+            }
+            if (!readProfileSnapshot(parts.second.empty() ? spec : parts.first,
+                                     workload.snapshot)) {
+                return false;
+            }
+            workloads.push_back(std::move(workload));
+        }
+        return true;
+    }
+
+    // A snapshot only applies to the function it was recorded from: the passes in front of
+    // this one must not have changed its blocks
+    bool matches(Function &F, const std::vector<SnapshotBlock> &blocks) {
+        if (blocks.size() != F.size()) {
+            return false;
+        }
+        auto block = blocks.begin();
+        for (BasicBlock &BB : F) {
+            if (getBlockShape(BB).hash != block->hash ||
+                block->edges.size() != BB.getTerminator()->getNumSuccessors()) {
+                return false;
+            }
+            block++;
+        }
+        return true;
+    }
+
+    bool annotate(Function &F, std::vector<Workload> &workloads) {
+        LLVMContext &context = F.getContext();
+        Type *doubleType = Type::getDoubleTy(context);
+        auto constant = [&](double value) {
+            return ConstantAsMetadata::get(ConstantFP::get(doubleType, value));
+        };
+
+        std::vector<std::vector<Metadata *>> perBlock(F.size());
+        for (Workload &workload : workloads) {
+            auto recorded = workload.snapshot.find(F.getName().str());
+            if (recorded == workload.snapshot.end()) {
+                continue;
+            }
+            if (!matches(F, recorded->second)) {
+                ++NumMismatched;
+                continue;
+            }
+            uint64_t maxCount = 0;
+            for (const SnapshotBlock &block : recorded->second) {
+                maxCount = std::max(maxCount, block.count);
+            }
+            for (size_t i = 0; i < recorded->second.size(); i++) {
+                const SnapshotBlock &block = recorded->second[i];
+                std::vector<Metadata *> operands{constant(workload.weight)};
+                operands.push_back(constant(maxCount ? (double)block.count / maxCount : 0));
+                for (uint64_t edge : block.edges) {
+                    operands.push_back(constant(maxCount ? (double)edge / maxCount : 0));
+                }
+                perBlock[i].push_back(MDNode::get(context, operands));
+            }
+        }
+        if (perBlock.empty() || perBlock[0].empty()) {
+            return false;
+        }
+
+        size_t i = 0;
+        for (BasicBlock &BB : F) {
+            BB.getTerminator()->setMetadata("ispre.workloads", MDNode::get(context, perBlock[i++]));
+        }
+        ++NumAnnotated;
+        return true;
+    }
+
+    bool runOnModule(Module &M) override {
+        std::vector<Workload> workloads;
+        if (WorkloadProfiles.empty() || !readWorkloads(workloads)) {
+            return false;
+        }
+        bool changed = false;
+        for (Function &F : M) {
+            if (!F.isDeclaration()) {
+                changed |= annotate(F, workloads);
+            }
+        }
+        return changed;
+    }
+};
+} // namespace
+
+char WorkloadsPass::ID = 0;
+static RegisterPass<WorkloadsPass>
+    X("ispre-workloads", "Attach per-workload hotness for the ISPRE passes", false, false);
@@ -11,6 +11,24 @@ help()
     echo "   - h     Print this help."
     echo "   - d     Delete intermediate files (but not compiled executable files)"
     echo "   - D     Delete all produced files"
+    echo "   - r     Print the ispre-remarks report of the multipass ISPRE build"
+    echo "   - c     Print the realized dynamic counts of an instrumented multipass ISPRE build"
+    echo "   - b     Measure the four binaries with repeated pinned runs and hardware counters"
+    echo "           (writes source_program.bench.json)"
+    echo "   - H     Like -b, and record the results for the current git revision in history.jsonl"
+    echo "   - a     Profile with perf LBR samples converted by llvm-profgen (AutoFDO) instead of"
+    echo "           instrumentation; profi repairs the sampled counts before the passes run"
+    echo "   - m     Estimate the cycles of every executed block of the four builds with llvm-mca"
+    echo "           (writes source_program.mca.json)"
+    echo "   - s     Add a context-sensitive (CSPGO) profiling round after inlining, and start every"
+    echo "           build from the -O1 bitcode annotated with both profiles"
+    echo "   - p     Also record a Ball-Larus path profile and build the hot regions from the hottest"
+    echo "           acyclic paths instead of thresholding blocks and edges one by one"
+    echo "   - f     Feedback: build with the deny list source_program.denylist if it exists, and add"
+    echo "           to it the speculations of the -c run used less than once per insertion"
+    echo "   - w file  Train on several workloads, one \"name weight arguments...\" per line (integer"
+    echo "           weights), and measure every build under each of them. A block is only hot"
+    echo "           if it is hot under a quorum of the workload weight (-ispre-workload-quorum)"
     echo "argument:"
     echo "   - source_program    A single .c file to compile and run stats on"
     echo "                       ** Note: omit the .c extension, i.e. \"example.c\" should just be \"example\"" 
@@ -26,8 +44,20 @@ get_bytes_from_bcanalysis () {
 
 delete_intermediate=0
 delete_all=0
+print_remarks=0
+print_counts=0
+run_bench=0
+record_history=0
+run_mca=0
+sample_profile=0
+workloads_file=""
+context_sensitive=0
+path_profile=0
+deny_list=0
+# Options and passes run in front of the ISPRE passes
+profile_passes=""
 # Get command line options
-while getopts ":hdD" option; do
+while getopts ":hdDrcbHmaspfw:" option; do
     case $option in
         h) # display help
             help
@@ -36,6 +66,28 @@ while getopts ":hdD" option; do
             delete_intermediate=1;;
         D) # delete all
             delete_all=1;;
+        r) # print remark report
+            print_remarks=1;;
+        c) # print realized counts
+            print_counts=1;;
+        b) # run the benchmark runner
+            run_bench=1;;
+        H) # run the benchmark runner and record the results
+            run_bench=1
+            record_history=1;;
+        m) # estimate block throughput
+            run_mca=1;;
+        a) # sample-based profile
+            sample_profile=1;;
+        s) # context-sensitive profile
+            context_sensitive=1;;
+        p) # path profile
+            path_profile=1;;
+        f) # deny-list feedback from the realized counts
+            deny_list=1
+            print_counts=1;;
+        w) # weighted training workloads
+            workloads_file=${OPTARG};;
         \?) # incorrect option
             echo "Error: Invalid option"
             exit 1;;
@@ -53,31 +105,102 @@ then
     exit 1
 fi
 
+if [ "$sample_profile" -eq 1 ] && [ -n "$workloads_file" ]; then
+    echo "Error: -w needs instrumented profiles and cannot be combined with -a"
+    exit 1
+fi
+if [ "$context_sensitive" -eq 1 ] && { [ "$sample_profile" -eq 1 ] || [ -n "$workloads_file" ]; }; then
+    echo "Error: -s cannot be combined with -a or -w"
+    exit 1
+fi
+
 # Get command line arguments
 source_program=${1}
 passes=${2:-"-ispre"}
 multipasses="--ispre --ispre2 --ispre3 --ispre4"
 llvm_library="../build/ISPRE/ISPRE.so"
+remarks_tool="../build/tools/ispre-remarks/ispre-remarks"
+runtime_library="../build/runtime/libispre_rt.a"
+bench_tool="../build/tools/ispre-runbench/ispre-runbench"
+history_tool="../build/tools/ispre-history/ispre-history"
+mca_tool="../build/tools/ispre-mca/ispre-mca"
+denylist_tool="../build/tools/ispre-denylist/ispre-denylist"
 
 # Delete outputs from any previous runs
-rm -f default.profraw ${source_program}_prof ${source_program}_ispre ${source_program}_multiispre ${source_program}_no_ispre ${source_program}_gvn *.bc ${source_program}.profdata *_output *.ll
+rm -f *.profraw *.blocks.json ${source_program}_prof ${source_program}_csprof ${source_program}_pathprof ${source_program}_ispre ${source_program}_multiispre ${source_program}_no_ispre ${source_program}_gvn ${source_program}_counted *.bc *.profdata *_output *.ll *.remarks.yaml *.counts *.bench.json *.mca.json *.sampleprof *.perf.data *.paths
 
-# Convert source code to bitcode (IR)
-clang -emit-llvm -Xclang -disable-O0-optnone -c ${source_program}.c -o ${source_program}.bc
-# Instrument profiler
-opt -enable-new-pm=0 -pgo-instr-gen -instrprof ${source_program}.bc -o ${source_program}.prof.bc
-# Generate binary executable with profiler embedded
-clang -fprofile-instr-generate ${source_program}.prof.bc -o ${source_program}_prof
+if [ "$sample_profile" -eq 1 ]; then
+    # Convert source code to bitcode (IR) with the line tables samples are matched against
+    clang -g -emit-llvm -Xclang -disable-O0-optnone -c ${source_program}.c -o ${source_program}.bc
+    # Sample the uninstrumented binary with the last branch records
+    clang ${source_program}.bc -o ${source_program}_prof
+    perf record -q -e cycles:u -j any,u -o ${source_program}.perf.data -- ./${source_program}_prof > correct_output
+    llvm-profgen --binary=${source_program}_prof --perfdata=${source_program}.perf.data --output=${source_program}.sampleprof
+    # Convert again, marking every function to take its counts from the sample profile
+    clang -g -emit-llvm -Xclang -disable-O0-optnone -fprofile-sample-use=${source_program}.sampleprof -c ${source_program}.c -o ${source_program}.bc
+    # Sampled counts are not flow-consistent; profi infers consistent block and edge counts
+    use_profile="-sample-profile -sample-profile-file=${source_program}.sampleprof -sample-profile-use-profi"
+else
+    # Convert source code to bitcode (IR)
+    clang -emit-llvm -Xclang -disable-O0-optnone -c ${source_program}.c -o ${source_program}.bc
+    # Instrument profiler
+    opt -enable-new-pm=0 -pgo-instr-gen -instrprof ${source_program}.bc -o ${source_program}.prof.bc
+    # Generate binary executable with profiler embedded
+    clang -fprofile-instr-generate ${source_program}.prof.bc -o ${source_program}_prof
+
+    # Generate profiled data
+    ./${source_program}_prof > correct_output
+    if [ -n "$workloads_file" ]; then
+        # One training run and block count snapshot per workload; the merged profile is their
+        # weighted mix and the snapshots let the passes check each block against the quorum
+        merge_inputs=""
+        profile_passes="${profile_passes} -ispre-workloads"
+        while read -r name weight args <&3; do
+            LLVM_PROFILE_FILE=${source_program}.${name}.profraw ./${source_program}_prof ${args} > ${name}_correct_output
+            llvm-profdata merge -o ${source_program}.${name}.profdata ${source_program}.${name}.profraw
+            opt -enable-new-pm=0 -o /dev/null -pgo-instr-use -pgo-test-profile-file=${source_program}.${name}.profdata -load ${llvm_library} -ispre-stale-profile -ispre-profile-snapshot-out=${source_program}.${name}.blocks.json < ${source_program}.bc
+            merge_inputs="${merge_inputs} -weighted-input=${weight},${source_program}.${name}.profraw"
+            profile_passes="${profile_passes} -ispre-workload-profile=${source_program}.${name}.blocks.json:${weight}"
+        done 3< ${workloads_file}
+        llvm-profdata merge -o ${source_program}.profdata ${merge_inputs}
+    else
+        llvm-profdata merge -o ${source_program}.profdata default.profraw
+    fi
+    use_profile="-pgo-instr-use -pgo-test-profile-file=${1}.profdata"
 
-# Generate profiled data
-./${source_program}_prof > correct_output
-llvm-profdata merge -o ${source_program}.profdata default.profraw
+    if [ "$context_sensitive" -eq 1 ]; then
+        # Second round, instrumented after the first profile has guided inlining, so that
+        # inlined bodies are counted per call site
+        opt -passes='default<O1>' -pgo-kind=pgo-instr-use-pipeline -profile-file=${source_program}.profdata -cspgo-kind=cspgo-instr-gen-pipeline -cs-profilegen-file=${source_program}.cs.profraw ${source_program}.bc -o ${source_program}.csgen.bc
+        clang -fprofile-instr-generate ${source_program}.csgen.bc -o ${source_program}_csprof
+        ./${source_program}_csprof > /dev/null
+        llvm-profdata merge -o ${source_program}.cs.profdata ${source_program}.profdata ${source_program}.cs.profraw
+        # Every build starts from the same inlined bitcode, annotated with both profiles.
+        # reg2mem returns it to the memory form the passes expect from -O0 code.
+        opt -passes='default<O1>' -pgo-kind=pgo-instr-use-pipeline -profile-file=${source_program}.cs.profdata -cspgo-kind=cspgo-instr-use-pipeline ${source_program}.bc -o ${source_program}.cs.bc
+        opt -enable-new-pm=0 -reg2mem ${source_program}.cs.bc -o ${source_program}.bc
+        use_profile=""
+    fi
+fi
+
+if [ "$path_profile" -eq 1 ]; then
+    # Count the acyclic paths of the same bitcode the passes will see
+    opt -enable-new-pm=0 -load ${llvm_library} -ispre-path-profile-gen ${source_program}.bc -o ${source_program}.pathgen.bc
+    clang ${source_program}.pathgen.bc ${runtime_library} -o ${source_program}_pathprof
+    ISPRE_PATHS_FILE=${source_program}.paths ./${source_program}_pathprof > /dev/null
+    profile_passes="${profile_passes} -ispre-path-profile=${source_program}.paths"
+fi
 
 # Use opt three times to compile with specific passes
-opt -enable-new-pm=0 -o ${source_program}.none.bc -pgo-instr-use -pgo-test-profile-file=${1}.profdata < ${source_program}.bc > /dev/null
-opt -enable-new-pm=0 -o ${source_program}.gvn.bc -pgo-instr-use -pgo-test-profile-file=${1}.profdata -gvn -dce < ${source_program}.bc > /dev/null
-opt -enable-new-pm=0 -o ${source_program}.ispre.bc -pgo-instr-use -pgo-test-profile-file=${1}.profdata -load ${llvm_library} ${passes} -dce < ${source_program}.bc > /dev/null
-opt -enable-new-pm=0 -o ${source_program}.multiispre.bc -pgo-instr-use -pgo-test-profile-file=${1}.profdata -load ${llvm_library} ${multipasses} -dce < ${source_program}.bc > /dev/null
+opt -enable-new-pm=0 -o ${source_program}.none.bc ${use_profile} < ${source_program}.bc > /dev/null
+opt -enable-new-pm=0 -o ${source_program}.gvn.bc ${use_profile} -gvn -dce < ${source_program}.bc > /dev/null
+# Speculations that did not pay off in earlier -f runs; the deny list is kept across runs
+if [ "$deny_list" -eq 1 ] && [ -f ${source_program}.denylist ]; then
+    profile_passes="${profile_passes} -ispre-deny-list=${source_program}.denylist"
+fi
+
+opt -enable-new-pm=0 -o ${source_program}.ispre.bc ${use_profile} -load ${llvm_library} ${profile_passes} ${passes} -dce < ${source_program}.bc > /dev/null
+opt -enable-new-pm=0 -o ${source_program}.multiispre.bc ${use_profile} -load ${llvm_library} ${profile_passes} ${multipasses} -dce -pass-remarks-output=${source_program}.remarks.yaml < ${source_program}.bc > /dev/null
 
 # Generate binary excutable before ISPRE: Unoptimized code
 clang ${source_program}.none.bc -o ${source_program}_no_ispre
@@ -150,13 +273,59 @@ else
     echo -e ""
     echo -e "   b. Code size (IR) of optimized code\n"
     echo -e "      ${bytes_moptimized} bytes, ${percent_mdifference}% change\n"
+
+    if [ "$print_remarks" -eq 1 ]; then
+        echo -e "=== ISPRE Remarks ==="
+        ${remarks_tool} -profiled-ir ${source_program}.none.bc ${source_program}.remarks.yaml
+    fi
+
+    if [ "$print_counts" -eq 1 ]; then
+        echo -e "=== ISPRE Realized Counts ==="
+        opt -enable-new-pm=0 -o ${source_program}.counted.bc ${use_profile} -load ${llvm_library} ${profile_passes} ${multipasses} -ispre-instrument -dce < ${source_program}.bc > /dev/null
+        clang ${source_program}.counted.bc ${runtime_library} -o ${source_program}_counted
+        ISPRE_COUNTS_FILE=${source_program}.counts ./${source_program}_counted > /dev/null
+        column -t -s $'\t' ${source_program}.counts
+        if [ "$deny_list" -eq 1 ]; then
+            ${denylist_tool} -o ${source_program}.denylist ${source_program}.counts
+        fi
+    fi
+
+    if [ "$run_bench" -eq 1 ]; then
+        echo -e "=== Repeated Runs ==="
+        compile="opt -enable-new-pm=0 -o /dev/null ${use_profile} -load ${llvm_library} ${profile_passes}"
+        ${bench_tool} -o ${source_program}.bench.json none=./${source_program}_no_ispre gvn=./${source_program}_gvn ispre=./${source_program}_ispre multiispre=./${source_program}_multiispre \
+            "compile_ispre=${compile} ${passes} ${source_program}.bc" "compile_multiispre=${compile} ${multipasses} ${source_program}.bc" \
+            "compile_multiispre_nocoldskip=${compile} -ispre-cold-percentile=0 ${multipasses} ${source_program}.bc"
+        if [ "$record_history" -eq 1 ]; then
+            ${history_tool} record -db history.jsonl -revision $(git rev-parse HEAD) -benchmark ${source_program} ${source_program}.bench.json
+        fi
+    fi
+
+    if [ -n "$workloads_file" ]; then
+        echo -e "=== Per-workload Runs ==="
+        while read -r name weight args <&3; do
+            echo ">> ${name} (weight ${weight})"
+            ./${source_program}_ispre ${args} > ${name}_ispre_output
+            ./${source_program}_multiispre ${args} > ${name}_multiispre_output
+            if [ "$(diff ${name}_correct_output ${name}_ispre_output)" != "" ] || [ "$(diff ${name}_correct_output ${name}_multiispre_output)" != "" ]; then
+                echo -e ">> FAIL - ${name}\n"
+                continue
+            fi
+            ${bench_tool} -baseline none -o ${source_program}.${name}.bench.json "none=./${source_program}_no_ispre ${args}" "ispre=./${source_program}_ispre ${args}" "multiispre=./${source_program}_multiispre ${args}"
+        done 3< ${workloads_file}
+    fi
+
+    if [ "$run_mca" -eq 1 ]; then
+        echo -e "=== Static Throughput Estimate ==="
+        ${mca_tool} -o ${source_program}.mca.json none=${source_program}.none.bc gvn=${source_program}.gvn.bc ispre=${source_program}.ispre.bc multiispre=${source_program}.multiispre.bc
+    fi
 fi
 
 # Cleanup
 if [ "$delete_intermediate" -eq 1 ] || [ "$delete_all" -eq 1 ]; then
-    rm -f default.profraw ${source_program}_prof *.bc ${source_program}.profdata *_output *.ll
+    rm -f *.profraw *.blocks.json ${source_program}_prof ${source_program}_csprof ${source_program}_pathprof *.bc *.profdata *_output *.ll *.remarks.yaml *.counts *.bench.json *.mca.json *.sampleprof *.perf.data *.paths
 fi
 
 if [ "$delete_all" -eq 1 ] ; then
-    rm -f ${source_program}_ispre ${source_program}_multiispre ${source_program}_no_ispre ${source_program}_gvn
+    rm -f ${source_program}_ispre ${source_program}_multiispre ${source_program}_no_ispre ${source_program}_gvn ${source_program}_counted ${source_program}.denylist
 fi
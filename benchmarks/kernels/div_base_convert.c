@@ -0,0 +1,31 @@
+#include <stdio.h>
+
+// Conversion of integers to digit strings in a radix that is switched rarely.
+//
+// Profile: 3M numbers of up to 20 digits, each digit costing a division and a modulo by
+// `radix`; the radix changes once per 300000 numbers, cycling through 7, 10 and 16.
+
+int main() {
+    unsigned long long radix = 10;
+    unsigned long long checksum = 0;
+    int digits[64];
+
+    for (unsigned long long n = 1; n <= 3000000; n++) {
+        unsigned long long value = n * 2654435761ULL;
+        int count = 0;
+        while (value != 0) {
+            digits[count++] = (int)(value % radix);
+            value /= radix;
+        }
+        for (int i = 0; i < count; i++) {
+            checksum = checksum * 3 + digits[i];
+        }
+        if (n % 300000 == 0) {
+            radix = radix == 10 ? 16 : radix == 16 ? 7 : 10;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <stdio.h>
+
+// Histogram bucketing of measurements with a bucket width computed from a configurable range.
+//
+// Profile: 30M values, each mapped to `(value - low) / ((high - low) / BUCKETS)`. The range
+// is widened when an out-of-range value appears, which happens a handful of times.
+
+#define BUCKETS 64
+
+int main() {
+    unsigned long long counts[BUCKETS];
+    unsigned long long seed = 47;
+    unsigned long long low = 0;
+    unsigned long long high = 1 << 20;
+    unsigned long long checksum = 0;
+
+    for (int b = 0; b < BUCKETS; b++) {
+        counts[b] = 0;
+    }
+
+    for (int n = 0; n < 30000000; n++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned long long value = seed >> 44;
+        if (n % 7000000 == 6999999) {
+            value = high + (seed >> 50);
+        }
+        if (value >= high) {
+            high = value + 1;
+            continue;
+        }
+        counts[(value - low) / ((high - low) / BUCKETS)]++;
+    }
+
+    for (int b = 0; b < BUCKETS; b++) {
+        checksum = checksum * 31 + counts[b];
+    }
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,32 @@
+#include <stdio.h>
+
+// Fixed-point rescaling of samples from one Q format to another.
+//
+// Profile: 30M samples, each computing `sample * outScale / inScale`. The input format is
+// renegotiated once per 2M samples.
+
+int main() {
+    short samples[4096];
+    unsigned long long seed = 41;
+    long long inScale = 1 << 12;
+    long long outScale = 1 << 15;
+    unsigned long long checksum = 0;
+
+    for (int i = 0; i < 4096; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        samples[i] = (short)(seed >> 48);
+    }
+
+    for (int n = 0; n < 30000000; n++) {
+        long long sample = samples[n & 4095];
+        long long scaled = sample * outScale / inScale;
+        checksum += (unsigned long long)scaled;
+        if (n % 2000000 == 1999999) {
+            inScale = inScale == 1 << 12 ? 1000 : 1 << 12;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
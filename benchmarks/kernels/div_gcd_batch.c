@@ -0,0 +1,33 @@
+#include <stdio.h>
+
+// Reduction of fractions to lowest terms with Euclid's algorithm.
+//
+// Profile: 2M fractions, each reduced by a remainder loop of a few to a few dozen steps.
+// The denominator base is re-randomized once per 100000 fractions.
+
+int main() {
+    unsigned long long seed = 43;
+    unsigned long long base = 360360;
+    unsigned long long checksum = 0;
+
+    for (int n = 0; n < 2000000; n++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned long long numerator = (seed >> 34) + 1;
+        unsigned long long denominator = base * ((seed >> 60) + 1);
+        unsigned long long a = numerator;
+        unsigned long long b = denominator;
+        while (b != 0) {
+            unsigned long long t = a % b;
+            a = b;
+            b = t;
+        }
+        checksum += numerator / a + denominator / a;
+        if (n % 100000 == 99999) {
+            base = 360360 + (seed >> 44);
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,24 @@
+#include <stdio.h>
+
+// Modular accumulation with a modulus that changes only between batches.
+//
+// Profile: 30M additions, each reducing `(value * factor) % modulus`. Both factor and modulus
+// are loop invariant except at batch boundaries, once per 1M values.
+
+int main() {
+    unsigned long long modulus = 1000003;
+    unsigned long long factor = 48271;
+    unsigned long long checksum = 0;
+
+    for (unsigned long long n = 0; n < 30000000; n++) {
+        checksum += (n * factor) % modulus;
+        if (n % 1000000 == 999999) {
+            modulus = 1000003 + (checksum & 1023) * 2;
+            factor = 48271 + (checksum >> 10 & 255);
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
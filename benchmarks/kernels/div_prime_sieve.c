@@ -0,0 +1,46 @@
+#include <stdio.h>
+
+// Trial division primality tests over a window, with the divisor list rebuilt rarely.
+//
+// Profile: 300000 candidates tested by division against up to 168 small primes; most
+// composite candidates exit within a few divisions. The candidate window jumps (and the
+// stride is recomputed as `window / 3`) once per 50000 candidates.
+
+int main() {
+    unsigned int primes[168];
+    int count = 0;
+    unsigned long long checksum = 0;
+    unsigned long long window = 1000000;
+
+    for (unsigned int n = 2; count < 168; n++) {
+        int prime = 1;
+        for (int i = 0; i < count && primes[i] * primes[i] <= n; i++) {
+            if (n % primes[i] == 0) {
+                prime = 0;
+                break;
+            }
+        }
+        if (prime) {
+            primes[count++] = n;
+        }
+    }
+
+    for (unsigned long long k = 0; k < 300000; k++) {
+        unsigned long long candidate = window + (k % 50000) * 2 + 1;
+        int prime = 1;
+        for (int i = 0; i < count; i++) {
+            if (candidate % primes[i] == 0) {
+                prime = 0;
+                break;
+            }
+        }
+        checksum += prime ? candidate % (window / 3) : 1;
+        if (k % 50000 == 49999) {
+            window += 999983;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
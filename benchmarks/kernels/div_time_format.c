@@ -0,0 +1,27 @@
+#include <stdio.h>
+
+// Breaking timestamps into days, hours, minutes and seconds with a timezone offset.
+//
+// Profile: 15M timestamps, each divided by constants after adding `offset * 60`. The
+// timezone offset changes once per 1M timestamps (a daylight saving transition).
+
+int main() {
+    long long offset = -300;
+    unsigned long long checksum = 0;
+
+    for (long long n = 0; n < 15000000; n++) {
+        long long t = 1600000000 + n * 37 + offset * 60;
+        long long days = t / 86400;
+        long long hours = t % 86400 / 3600;
+        long long minutes = t % 3600 / 60;
+        long long seconds = t % 60;
+        checksum += (unsigned long long)(days * 1000000 + hours * 10000 + minutes * 100 + seconds);
+        if (n % 1000000 == 999999) {
+            offset = offset == -300 ? -240 : -300;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,56 @@
+#include <stdio.h>
+
+// Table-free lexer state machine recognizing identifiers, numbers and operators, with a
+// rare pragma that changes the identifier hash seed.
+//
+// Profile: 30M characters. Identifier and number states are hot and fold characters into
+// `hash * 31 + c + seedMix`; operator tokens are every few characters and the pragma
+// character '#' appears about once per 50000 characters.
+
+enum { START, IDENT, NUMBER };
+
+#define SOURCE_SIZE 16384
+
+int main() {
+    static char source[SOURCE_SIZE];
+    unsigned long long seed = 37;
+    unsigned long long seedMix = 3;
+    unsigned long long checksum = 0;
+
+    for (int i = 0; i < SOURCE_SIZE; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned int r = (unsigned int)(seed >> 44);
+        source[i] = r % 50000 == 0 ? '#' : r % 6 == 0 ? '+' : r % 5 == 0 ? (char)('0' + r % 10)
+                                                                       : (char)('a' + r % 26);
+    }
+
+    int state = START;
+    unsigned long long hash = 0;
+    for (int n = 0; n < 30000000; n++) {
+        char c = source[n & (SOURCE_SIZE - 1)];
+        int letter = c >= 'a' && c <= 'z';
+        int digit = c >= '0' && c <= '9';
+        if (state == IDENT && (letter || digit)) {
+            hash = hash * 31 + c + seedMix;
+            continue;
+        }
+        if (state == NUMBER && digit) {
+            hash = hash * 10 + (c - '0') + seedMix;
+            continue;
+        }
+        if (state != START) {
+            checksum += hash;
+        }
+        hash = 0;
+        state = letter ? IDENT : digit ? NUMBER : START;
+        if (state != START) {
+            hash = c + seedMix;
+        } else if (c == '#') {
+            seedMix = checksum & 0xffff;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,77 @@
+#include <stdio.h>
+
+// Packet parser state machine: header, length, payload and checksum states.
+//
+// Profile: 30M input bytes, most of them in the PAYLOAD state, which accumulates
+// `byte ^ (key + sessionId)`. A control packet that rekeys the session arrives about once
+// per 40000 packets; framing errors that reset the machine are rarer still.
+
+enum { HEADER, LENGTH, PAYLOAD, CHECK };
+
+#define STREAM_SIZE 16384
+
+int main() {
+    static unsigned char stream[STREAM_SIZE];
+    unsigned long long seed = 13;
+    unsigned int key = 0x5a;
+    unsigned int sessionId = 7;
+    unsigned long long checksum = 0;
+    unsigned long long packets = 0;
+
+    int i = 0;
+    while (i < STREAM_SIZE) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        int length = 32 + (int)(seed >> 58);
+        if (i + length + 3 > STREAM_SIZE) {
+            break;
+        }
+        stream[i++] = (seed >> 20) % 40000 == 0 ? 0xc3 : 0xa5;
+        stream[i++] = (unsigned char)length;
+        for (int k = 0; k < length; k++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            stream[i++] = (unsigned char)(seed >> 56);
+        }
+        stream[i++] = 0;
+    }
+    int used = i;
+
+    int state = HEADER;
+    int remaining = 0;
+    int control = 0;
+    unsigned int accumulator = 0;
+    for (int n = 0; n < 30000000; n++) {
+        unsigned char byte = stream[n % used];
+        switch (state) {
+        case HEADER:
+            if (byte == 0xa5 || byte == 0xc3) {
+                control = byte == 0xc3;
+                state = LENGTH;
+            }
+            break;
+        case LENGTH:
+            remaining = byte;
+            accumulator = 0;
+            state = remaining ? PAYLOAD : HEADER;
+            break;
+        case PAYLOAD:
+            accumulator += byte ^ (key + sessionId);
+            if (--remaining == 0) {
+                state = CHECK;
+            }
+            break;
+        default:
+            if (control) {
+                key = accumulator & 0xff;
+                sessionId++;
+            }
+            checksum += accumulator;
+            packets++;
+            state = HEADER;
+            break;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum * 31 + packets);
+
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <stdio.h>
+
+// Run-length decoder with an escape byte that selects a literal run, and a rare dictionary
+// reset marker.
+//
+// Profile: 40M output bytes. Expanding runs is the hot loop and writes `value + bias`; literal
+// runs are about 10% of the input and the reset marker, which changes the bias, appears once
+// per 3000 runs.
+
+#define INPUT_SIZE 8192
+
+int main() {
+    static unsigned char input[INPUT_SIZE];
+    unsigned long long seed = 19;
+    unsigned int bias = 1;
+    unsigned long long checksum = 0;
+
+    for (int i = 0; i + 1 < INPUT_SIZE; i += 2) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned int r = (unsigned int)(seed >> 50);
+        input[i] = r % 3000 == 0 ? 0xfe : r % 10 == 0 ? 0xff : (unsigned char)(1 + r % 64);
+        input[i + 1] = (unsigned char)(seed >> 40);
+    }
+
+    unsigned long long produced = 0;
+    int position = 0;
+    while (produced < 40000000) {
+        unsigned int control = input[position];
+        unsigned int value = input[position + 1];
+        position = (position + 2) % INPUT_SIZE;
+        if (control == 0xfe) {
+            bias = value | 1;
+        } else if (control == 0xff) {
+            for (unsigned int k = 0; k < 4; k++) {
+                checksum += input[(position + k) % INPUT_SIZE] + bias;
+            }
+            produced += 4;
+        } else {
+            for (unsigned int k = 0; k < control; k++) {
+                checksum += value + bias;
+            }
+            produced += control;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
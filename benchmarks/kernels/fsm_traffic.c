@@ -0,0 +1,35 @@
+#include <stdio.h>
+
+// Traffic controller simulation: phases cycle green, yellow, red with timers, and a rare
+// maintenance mode reprograms the phase durations.
+//
+// Profile: 40M ticks. Almost every tick only compares the timer with
+// `duration[phase] * scale`; phase changes happen every few hundred ticks and maintenance
+// mode is entered once per 2M ticks.
+
+int main() {
+    unsigned int duration[3] = {300, 40, 260};
+    unsigned int scale = 2;
+    unsigned int timer = 0;
+    int phase = 0;
+    unsigned long long checksum = 0;
+
+    for (unsigned int tick = 0; tick < 40000000; tick++) {
+        timer++;
+        if (timer >= duration[phase] * scale) {
+            timer = 0;
+            phase = (phase + 1) % 3;
+            checksum += phase * 17 + tick % 101;
+        }
+        if (tick % 2000000 == 1999999) {
+            duration[0] = 200 + (unsigned int)(checksum % 200);
+            duration[2] = 150 + (unsigned int)(checksum % 150);
+            scale = scale == 2 ? 3 : 2;
+        }
+        checksum += (timer * 3) >> 8;
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,47 @@
+#include <stdio.h>
+
+// Vending machine controller accepting coins, dispensing items and giving change, with a
+// rare price update.
+//
+// Profile: 30M events. Coin insertions and the credit comparison against
+// `price[item] + fee` are hot; dispensing happens every few coins and the operator updates
+// the prices once per 1M events.
+
+enum { IDLE, COLLECTING, DISPENSE };
+
+int main() {
+    unsigned int price[4] = {125, 150, 95, 210};
+    unsigned int coins[4] = {5, 10, 25, 100};
+    unsigned int fee = 5;
+    unsigned long long seed = 29;
+    unsigned long long checksum = 0;
+    unsigned int credit = 0;
+    int item = 0;
+    int state = IDLE;
+
+    for (int n = 0; n < 30000000; n++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned int event = (unsigned int)(seed >> 60);
+        if (state == IDLE) {
+            item = event & 3;
+            credit = 0;
+            state = COLLECTING;
+        } else if (state == COLLECTING) {
+            credit += coins[event & 3];
+            if (credit >= price[item] + fee) {
+                state = DISPENSE;
+            }
+        } else {
+            checksum += credit - (price[item] + fee);
+            state = IDLE;
+        }
+        if (n % 1000000 == 999999) {
+            price[n / 1000000 % 4] += 5;
+            fee = fee == 5 ? 0 : 5;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,40 @@
+#include <stdio.h>
+
+// Table-driven CRC-32 over a buffer, with a rare switch of the initial value.
+//
+// Profile: 40M bytes through the byte loop, which indexes the table with
+// `(crc ^ byte) & 0xff`. The stream restarts with a new seed value every 4096 bytes.
+
+int main() {
+    unsigned int table[256];
+    unsigned char buffer[4096];
+    unsigned long long seed = 7;
+    unsigned int init = 0xffffffffu;
+    unsigned long long checksum = 0;
+
+    for (unsigned int i = 0; i < 256; i++) {
+        unsigned int c = i;
+        for (int k = 0; k < 8; k++) {
+            c = c & 1 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+        }
+        table[i] = c;
+    }
+    for (int i = 0; i < 4096; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        buffer[i] = (unsigned char)(seed >> 56);
+    }
+
+    unsigned int crc = init;
+    for (int n = 0; n < 40000000; n++) {
+        crc = table[(crc ^ buffer[n & 4095]) & 0xff] ^ (crc >> 8);
+        if ((n & 4095) == 4095) {
+            checksum += crc ^ init;
+            init = crc | 1;
+            crc = init;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <stdio.h>
+
+// 64-bit MurmurHash3 finalizer over a stream of integers, keyed by a seed.
+//
+// Profile: 20M mixes, each of which recomputes `seed ^ (seed >> 33)`. The seed changes
+// once every 250000 values, when a new hashing epoch starts.
+
+int main() {
+    unsigned long long seed = 0xc0ffee;
+    unsigned long long checksum = 0;
+
+    for (unsigned long long n = 0; n < 20000000; n++) {
+        unsigned long long h = n ^ (seed ^ (seed >> 33));
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        checksum += h;
+        if (n % 250000 == 0) {
+            seed = h;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#include <stdio.h>
+
+// Open addressing hash table with linear probing: lookups of mostly present keys.
+//
+// Profile: 6M lookups. The hash `(key * multiplier) >> shift` is computed for every lookup;
+// probes beyond the first slot are uncommon and the table is rebuilt with a new multiplier
+// once every 1M lookups.
+
+#define TABLE_BITS 12
+#define TABLE_SIZE (1 << TABLE_BITS)
+
+static unsigned long long keys[TABLE_SIZE];
+
+static void rebuild(unsigned long long multiplier, unsigned int shift) {
+    for (int i = 0; i < TABLE_SIZE; i++) {
+        keys[i] = 0;
+    }
+    for (unsigned long long k = 1; k <= TABLE_SIZE / 2; k++) {
+        unsigned int slot = (unsigned int)((k * 7919 * multiplier) >> shift) & (TABLE_SIZE - 1);
+        while (keys[slot] != 0) {
+            slot = (slot + 1) & (TABLE_SIZE - 1);
+        }
+        keys[slot] = k * 7919;
+    }
+}
+
+int main() {
+    unsigned long long multiplier = 0x9e3779b97f4a7c15ULL;
+    unsigned int shift = 64 - TABLE_BITS;
+    unsigned long long checksum = 0;
+    rebuild(multiplier, shift);
+
+    for (unsigned long long n = 0; n < 6000000; n++) {
+        unsigned long long key = (n % (TABLE_SIZE / 2 + 64) + 1) * 7919;
+        unsigned int slot = (unsigned int)((key * multiplier) >> shift) & (TABLE_SIZE - 1);
+        unsigned int probes = 0;
+        while (keys[slot] != key && keys[slot] != 0) {
+            slot = (slot + 1) & (TABLE_SIZE - 1);
+            probes++;
+        }
+        checksum += keys[slot] == key ? slot : probes;
+        if (n % 1000000 == 999999) {
+            multiplier += 2;
+            rebuild(multiplier, shift);
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
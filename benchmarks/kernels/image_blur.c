@@ -0,0 +1,60 @@
+#include <stdio.h>
+
+// 3x3 box blur of a grayscale image with clamped borders.
+//
+// Profile: 60 passes over a 512x512 image. Interior pixels take the hot path, which divides
+// the window sum by `norm`; the clamped border path covers about 1.5% of the pixels, and the
+// normalization changes once per 20 passes.
+
+#define W 512
+#define H 512
+
+int main() {
+    static unsigned char in[H][W];
+    static unsigned char out[H][W];
+    unsigned long long seed = 8;
+    unsigned int norm = 9;
+    unsigned long long checksum = 0;
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            in[y][x] = (unsigned char)(seed >> 56);
+        }
+    }
+
+    for (int pass = 0; pass < 60; pass++) {
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                unsigned int sum = 0;
+                if (y > 0 && y < H - 1 && x > 0 && x < W - 1) {
+                    sum = in[y - 1][x - 1] + in[y - 1][x] + in[y - 1][x + 1] + in[y][x - 1] +
+                          in[y][x] + in[y][x + 1] + in[y + 1][x - 1] + in[y + 1][x] +
+                          in[y + 1][x + 1];
+                } else {
+                    for (int dy = -1; dy <= 1; dy++) {
+                        for (int dx = -1; dx <= 1; dx++) {
+                            int yy = y + dy < 0 ? 0 : y + dy >= H ? H - 1 : y + dy;
+                            int xx = x + dx < 0 ? 0 : x + dx >= W ? W - 1 : x + dx;
+                            sum += in[yy][xx];
+                        }
+                    }
+                }
+                out[y][x] = (unsigned char)(sum / norm);
+            }
+        }
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                in[y][x] = out[y][x];
+                checksum += out[y][x];
+            }
+        }
+        if (pass % 20 == 19) {
+            norm = norm == 9 ? 8 : 9;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
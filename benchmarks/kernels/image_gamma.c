@@ -0,0 +1,40 @@
+#include <stdio.h>
+
+// Gamma correction through a piecewise-linear curve with rarely changing knee parameters.
+//
+// Profile: 25M pixels. Pixels below the knee (about 75%) use `pixel * slopeLow`, the rest
+// use `knee * slopeLow + (pixel - knee) * slopeHigh`; the curve is retuned once per frame of
+// 1M pixels.
+
+int main() {
+    unsigned char frame[8192];
+    unsigned long long seed = 12;
+    unsigned int knee = 192;
+    unsigned int slopeLow = 5;
+    unsigned int slopeHigh = 2;
+    unsigned long long checksum = 0;
+
+    for (int i = 0; i < 8192; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        frame[i] = (unsigned char)(seed >> 56);
+    }
+
+    for (int n = 0; n < 25000000; n++) {
+        unsigned int pixel = frame[n & 8191];
+        unsigned int mapped;
+        if (pixel < knee) {
+            mapped = pixel * slopeLow;
+        } else {
+            mapped = knee * slopeLow + (pixel - knee) * slopeHigh;
+        }
+        checksum += mapped >> 2;
+        if (n % 1000000 == 999999) {
+            knee = 160 + (unsigned int)(checksum & 63);
+            slopeLow = 4 + (unsigned int)(checksum >> 6 & 3);
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
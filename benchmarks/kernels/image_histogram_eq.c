@@ -0,0 +1,56 @@
+#include <stdio.h>
+
+// Histogram equalization: build a histogram, derive a cumulative lookup table and remap.
+//
+// Profile: 40 frames of 512x512 pixels. Building the histogram and remapping are the hot
+// loops; the lookup table `(cdf[v] - cdfMin) * 255 / (total - cdfMin)` is rebuilt once per
+// frame, and an almost-constant frame (never, for this input) would skip the remap.
+
+#define PIXELS (512 * 512)
+
+int main() {
+    static unsigned char image[PIXELS];
+    unsigned int histogram[256];
+    unsigned int cdf[256];
+    unsigned char lut[256];
+    unsigned long long seed = 10;
+    unsigned long long checksum = 0;
+
+    for (int i = 0; i < PIXELS; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        image[i] = (unsigned char)(64 + (seed >> 57));
+    }
+
+    for (int frame = 0; frame < 40; frame++) {
+        for (int v = 0; v < 256; v++) {
+            histogram[v] = 0;
+        }
+        for (int i = 0; i < PIXELS; i++) {
+            histogram[image[i]]++;
+        }
+        unsigned int running = 0;
+        unsigned int cdfMin = 0;
+        for (int v = 0; v < 256; v++) {
+            running += histogram[v];
+            cdf[v] = running;
+            if (cdfMin == 0) {
+                cdfMin = running;
+            }
+        }
+        if (cdfMin == PIXELS) {
+            continue;
+        }
+        for (int v = 0; v < 256; v++) {
+            unsigned long long scaled = (unsigned long long)(cdf[v] - cdfMin) * 255;
+            lut[v] = (unsigned char)(scaled / (PIXELS - cdfMin));
+        }
+        for (int i = 0; i < PIXELS; i++) {
+            image[i] = (unsigned char)((lut[image[i]] + frame) & 0xff);
+            checksum += image[i];
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
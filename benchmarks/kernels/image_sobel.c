@@ -0,0 +1,45 @@
+#include <stdio.h>
+
+// Sobel edge detector with a threshold, counting edge pixels.
+//
+// Profile: 40 passes over a 512x512 image. The gradient of every interior pixel is compared
+// with `threshold * threshold`; the threshold adapts once per pass, when the edge density
+// of the previous pass is known.
+
+#define W 512
+#define H 512
+
+int main() {
+    static unsigned char image[H][W];
+    unsigned long long seed = 4;
+    int threshold = 40;
+    unsigned long long checksum = 0;
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            image[y][x] = (unsigned char)((x * 3 + y * 5) / 7 + (seed >> 60));
+        }
+    }
+
+    for (int pass = 0; pass < 40; pass++) {
+        unsigned long long edges = 0;
+        for (int y = 1; y < H - 1; y++) {
+            for (int x = 1; x < W - 1; x++) {
+                int gx = image[y - 1][x + 1] + 2 * image[y][x + 1] + image[y + 1][x + 1] -
+                         image[y - 1][x - 1] - 2 * image[y][x - 1] - image[y + 1][x - 1];
+                int gy = image[y + 1][x - 1] + 2 * image[y + 1][x] + image[y + 1][x + 1] -
+                         image[y - 1][x - 1] - 2 * image[y - 1][x] - image[y - 1][x + 1];
+                if (gx * gx + gy * gy > threshold * threshold) {
+                    edges++;
+                }
+            }
+        }
+        checksum = checksum * 31 + edges;
+        threshold = edges > (W * H) / 4 ? threshold + 3 : threshold - 1;
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,39 @@
+#include <stdio.h>
+
+// Register machine interpreter: each instruction reads two registers and writes a third.
+//
+// Profile: 8M trips around a 6 instruction loop body. The operand decode `(insn >> 8) & 7`
+// is recomputed for every instruction; the STORE-to-code path that patches the program
+// (self-modifying code) runs once per 100000 trips.
+
+#define CODE_LENGTH 6
+
+int main() {
+    unsigned int code[CODE_LENGTH] = {0x010203, 0x020304, 0x030405, 0x040506, 0x050607, 0x060701};
+    unsigned long long regs[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+    unsigned long long checksum = 0;
+    unsigned int patch = 1;
+
+    for (int trip = 0; trip < 8000000; trip++) {
+        for (int pc = 0; pc < CODE_LENGTH; pc++) {
+            unsigned int insn = code[pc];
+            unsigned int dst = (insn >> 16) & 7;
+            unsigned int lhs = (insn >> 8) & 7;
+            unsigned int rhs = insn & 7;
+            if (pc % 2 == 0) {
+                regs[dst] = regs[lhs] + regs[rhs] * patch;
+            } else {
+                regs[dst] = regs[lhs] ^ (regs[rhs] + patch);
+            }
+        }
+        if (trip % 100000 == 0) {
+            patch = (unsigned int)(regs[0] & 15) + 1;
+            code[trip / 100000 % CODE_LENGTH] ^= 0x000101;
+        }
+        checksum += regs[trip & 7];
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,67 @@
+#include <stdio.h>
+
+// Stack machine evaluating a fixed postfix expression over a sliding input window.
+//
+// Profile: 3M evaluations of a 9 token expression. PUSH and arithmetic tokens are hot; the
+// stack overflow check that compacts the stack is never taken and the "reload constants"
+// token that refreshes `k` from the input runs once every 50000 evaluations.
+
+#define TOKENS 9
+
+enum { T_PUSH_X, T_PUSH_K, T_ADD, T_MUL, T_SUB, T_RELOAD };
+
+int main() {
+    int expr[TOKENS] = {T_PUSH_X, T_PUSH_K, T_MUL,    T_PUSH_X, T_ADD,
+                        T_PUSH_K, T_SUB,    T_RELOAD, T_ADD};
+    unsigned long long stack[16];
+    unsigned long long input[256];
+    unsigned long long seed = 12345;
+    unsigned long long k = 17;
+    unsigned long long checksum = 0;
+
+    for (int i = 0; i < 256; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        input[i] = seed >> 40;
+    }
+
+    for (int n = 0; n < 3000000; n++) {
+        unsigned long long x = input[n & 255];
+        int sp = 0;
+        for (int t = 0; t < TOKENS; t++) {
+            switch (expr[t]) {
+            case T_PUSH_X:
+                stack[sp++] = x + k * 3;
+                break;
+            case T_PUSH_K:
+                stack[sp++] = k * 3;
+                break;
+            case T_ADD:
+                sp--;
+                stack[sp - 1] += stack[sp];
+                break;
+            case T_MUL:
+                sp--;
+                stack[sp - 1] *= stack[sp];
+                break;
+            case T_SUB:
+                sp--;
+                stack[sp - 1] -= stack[sp];
+                break;
+            case T_RELOAD:
+                if (n % 50000 == 0) {
+                    k = input[(n / 50000) & 255] & 1023;
+                }
+                stack[sp++] = 0;
+                break;
+            }
+            if (sp >= 16) {
+                sp = 1;
+            }
+        }
+        checksum += stack[0];
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
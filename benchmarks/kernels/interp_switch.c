@@ -0,0 +1,58 @@
+#include <stdio.h>
+
+// Bytecode interpreter with a switch dispatch loop over a small accumulator machine.
+//
+// Profile: the dispatch loop runs 40M instructions. ADD/MUL/XOR/JNZ take over 99% of them and
+// all use `scale * bias`; the RECONF opcode that rewrites `scale` and `bias` executes once
+// every 65536 loop trips of the program.
+
+enum { OP_ADD, OP_MUL, OP_XOR, OP_JNZ, OP_RECONF, OP_HALT };
+
+#define PROGRAM_LENGTH 6
+
+int main() {
+    int program[PROGRAM_LENGTH] = {OP_ADD, OP_MUL, OP_XOR, OP_RECONF, OP_JNZ, OP_HALT};
+    unsigned long long acc = 1;
+    unsigned long long scale = 3;
+    unsigned long long bias = 7;
+    unsigned long long counter = 10000000;
+    unsigned long long checksum = 0;
+    int pc = 0;
+    int running = 1;
+
+    while (running) {
+        switch (program[pc]) {
+        case OP_ADD:
+            acc += scale * bias;
+            pc++;
+            break;
+        case OP_MUL:
+            acc = acc * 31 + scale * bias;
+            pc++;
+            break;
+        case OP_XOR:
+            acc ^= (scale * bias) >> 3;
+            pc++;
+            break;
+        case OP_RECONF:
+            if ((counter & 0xffff) == 0) {
+                scale = (acc & 0xff) + 1;
+                bias = (acc >> 8 & 0xff) + 1;
+            }
+            pc++;
+            break;
+        case OP_JNZ:
+            checksum += acc;
+            counter--;
+            pc = counter != 0 ? 0 : pc + 1;
+            break;
+        default:
+            running = 0;
+            break;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <stdio.h>
+
+// Interpreter with a function-table dispatch (the portable form of threaded code).
+//
+// Profile: 20M handler calls spread evenly over four arithmetic handlers, each of which
+// reads `vm.base + vm.step`. The handler that reconfigures base and step is reached once per
+// 200000 dispatches.
+
+struct VM {
+    unsigned long long acc;
+    unsigned long long base;
+    unsigned long long step;
+};
+
+static void op_add(struct VM *vm) { vm->acc += vm->base + vm->step; }
+
+static void op_shift(struct VM *vm) { vm->acc ^= vm->acc >> ((vm->base + vm->step) & 15); }
+
+static void op_mul(struct VM *vm) { vm->acc *= (vm->base + vm->step) | 1; }
+
+static void op_sub(struct VM *vm) { vm->acc -= vm->base + vm->step; }
+
+static void op_reconf(struct VM *vm) {
+    vm->base = vm->acc & 0xfff;
+    vm->step = (vm->acc >> 12) & 0xff;
+}
+
+int main() {
+    void (*handlers[5])(struct VM *) = {op_add, op_shift, op_mul, op_sub, op_reconf};
+    struct VM vm = {1, 5, 9};
+    unsigned long long checksum = 0;
+
+    for (int i = 0; i < 20000000; i++) {
+        int op = i & 3;
+        if (i % 200000 == 199999) {
+            op = 4;
+        }
+        handlers[op](&vm);
+        checksum += vm.acc >> 32;
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
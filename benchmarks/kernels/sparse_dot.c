@@ -0,0 +1,55 @@
+#include <stdio.h>
+
+// Dot products of sparse vectors stored as sorted (index, value) lists, merged pairwise.
+//
+// Profile: 20000 merges of two 512 entry lists. The index comparisons of the merge are hot
+// and equal indices (about one in eight steps) accumulate `a * b * weight`; the weight is
+// retuned once per 2000 merges.
+
+#define LENGTH 512
+#define VECTORS 64
+
+int main() {
+    static int index[VECTORS][LENGTH];
+    static long long value[VECTORS][LENGTH];
+    unsigned long long seed = 9;
+    long long weight = 2;
+    unsigned long long checksum = 0;
+
+    for (int v = 0; v < VECTORS; v++) {
+        int i = 0;
+        for (int k = 0; k < LENGTH; k++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            i += 1 + (int)(seed >> 61);
+            index[v][k] = i;
+            value[v][k] = (long long)(seed >> 56) - 128;
+        }
+    }
+
+    for (int n = 0; n < 20000; n++) {
+        int a = n % VECTORS;
+        int b = (n * 7 + 3) % VECTORS;
+        int i = 0;
+        int j = 0;
+        long long dot = 0;
+        while (i < LENGTH && j < LENGTH) {
+            if (index[a][i] < index[b][j]) {
+                i++;
+            } else if (index[a][i] > index[b][j]) {
+                j++;
+            } else {
+                dot += value[a][i] * value[b][j] * weight;
+                i++;
+                j++;
+            }
+        }
+        checksum += (unsigned long long)dot;
+        if (n % 2000 == 1999) {
+            weight = (long long)(checksum % 5) + 1;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
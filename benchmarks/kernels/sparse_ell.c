@@ -0,0 +1,56 @@
+#include <stdio.h>
+
+// Sparse matrix-vector product in ELLPACK format, where short rows are padded with
+// explicit zero entries marked by column -1.
+//
+// Profile: 300 products over 4096 rows of width 10. Padding entries (about 20%) take the
+// skip branch; the damping factor `num / den` used for every real entry is updated once per
+// 50 products.
+
+#define ROWS 4096
+#define WIDTH 10
+
+int main() {
+    static int column[ROWS][WIDTH];
+    static long long value[ROWS][WIDTH];
+    static long long x[ROWS];
+    static long long y[ROWS];
+    unsigned long long seed = 77;
+    long long num = 7;
+    long long den = 3;
+    unsigned long long checksum = 0;
+
+    for (int r = 0; r < ROWS; r++) {
+        for (int k = 0; k < WIDTH; k++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            column[r][k] = (seed >> 60) < 3 ? -1 : (int)(seed >> 40) % ROWS;
+            value[r][k] = (long long)(seed >> 58) + 1;
+        }
+        x[r] = r % 13;
+    }
+
+    for (int iteration = 0; iteration < 300; iteration++) {
+        for (int r = 0; r < ROWS; r++) {
+            long long sum = 0;
+            for (int k = 0; k < WIDTH; k++) {
+                if (column[r][k] < 0) {
+                    continue;
+                }
+                sum += value[r][k] * x[column[r][k]] * (num / den);
+            }
+            y[r] = sum;
+        }
+        for (int r = 0; r < ROWS; r++) {
+            x[r] = y[r] % 1021;
+            checksum += (unsigned long long)x[r];
+        }
+        if (iteration % 50 == 49) {
+            num = (long long)(checksum % 13) + 3;
+            den = (long long)(checksum % 3) + 1;
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,43 @@
+#include <stdio.h>
+
+// Case-insensitive comparison of a key against a dictionary, folding with a locale offset.
+//
+// Profile: 2M comparisons of 12 character keys; each character is folded with
+// `c + (fold - 'A')` when it is upper case. The fold offset changes (a "locale switch")
+// once per 100000 comparisons.
+
+#define WORDS 256
+#define LENGTH 12
+
+int main() {
+    static char dictionary[WORDS][LENGTH];
+    unsigned long long seed = 31;
+    char fold = 'a';
+    unsigned long long checksum = 0;
+
+    for (int w = 0; w < WORDS; w++) {
+        for (int i = 0; i < LENGTH; i++) {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            dictionary[w][i] = (char)((seed >> 63 ? 'A' : 'a') + (seed >> 40) % 4);
+        }
+    }
+
+    for (int n = 0; n < 2000000; n++) {
+        char *key = dictionary[n & (WORDS - 1)];
+        char *word = dictionary[(n * 7) & (WORDS - 1)];
+        int equal = 0;
+        for (int i = 0; i < LENGTH; i++) {
+            char a = key[i] >= 'A' && key[i] <= 'Z' ? (char)(key[i] + (fold - 'A')) : key[i];
+            char b = word[i] >= 'A' && word[i] <= 'Z' ? (char)(word[i] + (fold - 'A')) : word[i];
+            equal += a == b;
+        }
+        checksum += equal;
+        if (n % 100000 == 99999) {
+            fold = fold == 'a' ? 'A' : 'a';
+        }
+    }
+
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <stdio.h>
+
+// CSV field parser: converts numeric fields to integers and sums each column.
+//
+// Profile: 30M characters. Digits are the hot path (`value * 10 + digit - '0'`); the
+// separator and newline branches run every few characters, and a quoted field that toggles
+// the quoting state appears once per 2000 characters.
+
+#define TEXT_SIZE 16384
+#define COLUMNS 4
+
+int main() {
+    static char text[TEXT_SIZE];
+    unsigned long long seed = 23;
+    unsigned long long columns[COLUMNS] = {0, 0, 0, 0};
+    char separator = ',';
+
+    for (int i = 0; i < TEXT_SIZE; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned int r = (unsigned int)(seed >> 52);
+        if (r % 2000 == 0) {
+            text[i] = '"';
+        } else if (r % 7 == 0) {
+            text[i] = ',';
+        } else {
+            text[i] = r % 29 == 0 ? '\n' : (char)('0' + r % 10);
+        }
+    }
+
+    unsigned long long value = 0;
+    int column = 0;
+    int quoted = 0;
+    for (int n = 0; n < 30000000; n++) {
+        char c = text[n & (TEXT_SIZE - 1)];
+        if (c >= '0' && c <= '9') {
+            value = value * 10 + (c - '0') + quoted;
+        } else if (c == separator || c == '\n') {
+            columns[column] += value;
+            value = 0;
+            column = c == '\n' ? 0 : (column + 1) % COLUMNS;
+        } else {
+            quoted = !quoted;
+        }
+    }
+
+    unsigned long long checksum = 0;
+    for (int i = 0; i < COLUMNS; i++) {
+        checksum = checksum * 31 + columns[i];
+    }
+    printf("Checksum: %llu\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,46 @@
+#include <stdio.h>
+
+// Tokenizer counting words and word lengths in a text buffer with a configurable delimiter.
+//
+// Profile: 40M characters scanned. Every character is compared against `delim` and
+// `delim2 = delim + offset`; the delimiter pair changes once per 1M characters, when the
+// "input format" switches.
+
+#define TEXT_SIZE 8192
+
+int main() {
+    char text[TEXT_SIZE];
+    unsigned long long seed = 5;
+    char delim = ' ';
+    char offset = 12;
+    unsigned long long words = 0;
+    unsigned long long lengths = 0;
+
+    for (int i = 0; i < TEXT_SIZE; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        int r = (int)(seed >> 58);
+        text[i] = r < 8 ? ' ' : r < 12 ? ',' : (char)('a' + r % 26);
+    }
+
+    int length = 0;
+    for (int n = 0; n < 40000000; n++) {
+        char c = text[n & (TEXT_SIZE - 1)];
+        if (c == delim || c == delim + offset) {
+            if (length > 0) {
+                words++;
+                lengths += length;
+            }
+            length = 0;
+        } else {
+            length++;
+        }
+        if (n % 1000000 == 999999) {
+            delim = delim == ' ' ? ',' : ' ';
+            offset = (char)(delim == ' ' ? 12 : -12);
+        }
+    }
+
+    printf("Checksum: %llu\n", words * 1000003 + lengths);
+
+    return 0;
+}
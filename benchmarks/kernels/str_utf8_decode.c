@@ -0,0 +1,62 @@
+#include <stdio.h>
+
+// UTF-8 decoder counting code points and summing their values.
+//
+// Profile: 30M bytes. ASCII bytes (about 90%) take the first branch; two and three byte
+// sequences are uncommon and invalid bytes, which reset the replacement character in use,
+// are rare.
+
+#define TEXT_SIZE 16384
+
+int main() {
+    static unsigned char text[TEXT_SIZE + 4];
+    unsigned long long seed = 17;
+    unsigned long long points = 0;
+    unsigned long long sum = 0;
+    unsigned int replacement = 0xfffd;
+    int size = 0;
+
+    while (size < TEXT_SIZE) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        unsigned int r = (unsigned int)(seed >> 54);
+        if (r < 920) {
+            text[size++] = (unsigned char)(32 + r % 95);
+        } else if (r < 990) {
+            text[size++] = (unsigned char)(0xc2 + r % 30);
+            text[size++] = (unsigned char)(0x80 + r % 64);
+        } else if (r < 1020) {
+            text[size++] = 0xe2;
+            text[size++] = (unsigned char)(0x80 + r % 64);
+            text[size++] = (unsigned char)(0x80 + (r >> 2) % 64);
+        } else {
+            text[size++] = 0xff;
+        }
+    }
+
+    for (int round = 0; round < 30000000 / TEXT_SIZE; round++) {
+        int i = 0;
+        while (i < TEXT_SIZE) {
+            unsigned int c = text[i];
+            if (c < 0x80) {
+                sum += c + (replacement >> 8);
+                i++;
+            } else if ((c & 0xe0) == 0xc0) {
+                sum += ((c & 0x1f) << 6 | (text[i + 1] & 0x3f)) + (replacement >> 8);
+                i += 2;
+            } else if ((c & 0xf0) == 0xe0) {
+                sum += ((c & 0x0f) << 12 | (text[i + 1] & 0x3f) << 6 | (text[i + 2] & 0x3f)) +
+                       (replacement >> 8);
+                i += 3;
+            } else {
+                replacement = replacement == 0xfffd ? 0x3f : 0xfffd;
+                sum += replacement;
+                i++;
+            }
+            points++;
+        }
+    }
+
+    printf("Checksum: %llu\n", points * 1000003 + sum);
+
+    return 0;
+}
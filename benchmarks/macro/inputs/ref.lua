@@ -0,0 +1,56 @@
+-- Reference input for the Lua macro benchmark: the training workload at a larger scale, plus
+-- pattern matching, closures and string concatenation
+local n = 400000
+
+local function fib(k)
+    if k < 2 then
+        return k
+    end
+    return fib(k - 1) + fib(k - 2)
+end
+
+local t = {}
+for i = 1, n do
+    t[i] = (i * 7919) % 1000
+end
+table.sort(t)
+
+local counts = {}
+for i = 1, n // 10 do
+    local word = string.format("w%d", i % 977)
+    counts[word] = (counts[word] or 0) + 1
+end
+local s = 0
+for word, count in pairs(counts) do
+    s = s + #word * count
+end
+
+local acc = 0
+for i = 1, n do
+    acc = (acc + t[i] * i) % 1000000007
+end
+
+local parts = {}
+for i = 1, 20000 do
+    parts[#parts + 1] = "key" .. i .. "=" .. (i * 31) % 97
+end
+local text = table.concat(parts, ";")
+local matched = 0
+for key, value in text:gmatch("key(%d+)=(%d+)") do
+    matched = matched + tonumber(key) % 7 + tonumber(value)
+end
+
+local function counter(step)
+    local total = 0
+    return function()
+        total = total + step
+        return total
+    end
+end
+local tick = counter(3)
+local ticks = 0
+for _ = 1, n do
+    ticks = tick()
+end
+
+print(fib(27), s, acc, matched, ticks)
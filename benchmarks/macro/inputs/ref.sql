@@ -0,0 +1,16 @@
+-- Reference input for the SQLite macro benchmark: the training workload at a larger scale,
+-- plus string functions, a correlated subquery and a window function
+CREATE TABLE t(id INTEGER PRIMARY KEY, a INTEGER, b TEXT);
+WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 200000)
+INSERT INTO t SELECT x, (x * 7919) % 1000, printf('row%05d', x % 977) FROM c;
+CREATE INDEX t_a ON t(a);
+CREATE INDEX t_b ON t(b);
+SELECT count(*), sum(a), max(b) FROM t WHERE a BETWEEN 100 AND 600;
+SELECT b, count(*) FROM t GROUP BY b ORDER BY 2 DESC, 1 LIMIT 5;
+UPDATE t SET a = a + 1 WHERE id % 13 = 0;
+SELECT sum(t1.a * t2.a) FROM t t1 JOIN t t2 ON t1.a = t2.id WHERE t1.id < 50000;
+SELECT count(*) FROM t WHERE upper(b) LIKE 'ROW00%' AND length(b) = 8;
+SELECT sum(a) FROM t WHERE a > (SELECT avg(a) FROM t t2 WHERE t2.b = 'row00042');
+SELECT max(s) FROM (SELECT sum(a) OVER (ORDER BY id ROWS 50 PRECEDING) AS s FROM t);
+DELETE FROM t WHERE id % 7 = 0;
+SELECT count(*), total(a) FROM t;
@@ -0,0 +1,33 @@
+-- Training input for the Lua macro benchmark: recursion, sorting, string formatting and
+-- hash table updates at a small scale
+local n = 50000
+
+local function fib(k)
+    if k < 2 then
+        return k
+    end
+    return fib(k - 1) + fib(k - 2)
+end
+
+local t = {}
+for i = 1, n do
+    t[i] = (i * 7919) % 1000
+end
+table.sort(t)
+
+local counts = {}
+for i = 1, n // 10 do
+    local word = string.format("w%d", i % 977)
+    counts[word] = (counts[word] or 0) + 1
+end
+local s = 0
+for word, count in pairs(counts) do
+    s = s + #word * count
+end
+
+local acc = 0
+for i = 1, n do
+    acc = (acc + t[i] * i) % 1000000007
+end
+
+print(fib(20), s, acc)
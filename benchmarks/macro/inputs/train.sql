@@ -0,0 +1,11 @@
+-- Training input for the SQLite macro benchmark: small table, index, grouping and a join
+CREATE TABLE t(id INTEGER PRIMARY KEY, a INTEGER, b TEXT);
+WITH RECURSIVE c(x) AS (SELECT 1 UNION ALL SELECT x + 1 FROM c WHERE x < 20000)
+INSERT INTO t SELECT x, (x * 7919) % 1000, printf('row%05d', x % 977) FROM c;
+CREATE INDEX t_a ON t(a);
+SELECT count(*), sum(a), max(b) FROM t WHERE a BETWEEN 100 AND 600;
+SELECT b, count(*) FROM t GROUP BY b ORDER BY 2 DESC, 1 LIMIT 5;
+UPDATE t SET a = a + 1 WHERE id % 13 = 0;
+SELECT sum(t1.a * t2.a) FROM t t1 JOIN t t2 ON t1.a = t2.id WHERE t1.id < 5000;
+DELETE FROM t WHERE id % 7 = 0;
+SELECT count(*), total(a) FROM t;
@@ -0,0 +1,204 @@
+#!/bin/bash
+
+# help output for program
+help()
+{
+    # Display Help
+    echo "Helper script to build real-world C programs as single modules, compile them with the four pass combinations of get_statistics.sh and compare them on a reference input."
+    echo
+    echo "Syntax: macro [-h] [-k] [-p] [-n runs] [program...]"
+    echo "options:"
+    echo "   - h     Print this help."
+    echo "   - k     Keep the build products in _work/ (the downloads are always kept)"
+    echo "   - p     Pin archives that have no entry in sources.sha256 or sources.sha3-256 by recording"
+    echo "           their SHA-256"
+    echo "   - n     Measured runs of every variant (defaults to 5)"
+    echo "argument:"
+    echo "   - program    One or more of sqlite, lua, zlib"
+    echo "                ** Defaults to all three"
+}
+
+keep=0
+pin=0
+runs=5
+# Get command line options
+while getopts ":hkpn:" option; do
+    case $option in
+        h) # display help
+            help
+            exit;;
+        k) # keep build products
+            keep=1;;
+        p) # pin unpinned archives
+            pin=1;;
+        n) # measured runs
+            runs=${OPTARG};;
+        \?) # incorrect option
+            echo "Error: Invalid option"
+            exit 1;;
+    esac
+done
+# Shift cli arguments to ignore options
+shift "$((OPTIND-1))"
+
+programs=${@:-"sqlite lua zlib"}
+multipasses="--ispre --ispre2 --ispre3 --ispre4"
+
+cd "$(dirname "$0")"
+llvm_library="$(realpath ../../build/ISPRE/ISPRE.so)"
+bench_tool="$(realpath ../../build/tools/ispre-runbench/ispre-runbench)"
+work="_work"
+mkdir -p ${work}/downloads
+
+# Pinned releases. The programs are fetched rather than checked in, and every archive must match
+# its SHA-256 in sources.sha256, or the SHA3-256 in sources.sha3-256 for releases that publish
+# only that (sqlite.org). A program whose archive has no entry is skipped unless -p is given.
+sqlite_url="https://www.sqlite.org/2024/sqlite-amalgamation-3450300.zip"
+lua_url="https://www.lua.org/ftp/lua-5.4.6.tar.gz"
+zlib_url="https://zlib.net/fossils/zlib-1.3.1.tar.gz"
+
+# Download, verify and unpack one archive into ${work}/<name>; fails if it cannot be verified
+fetch()
+{
+    name=$1
+    url=$2
+    archive=${work}/downloads/$(basename ${url})
+    if [ ! -f ${archive} ]; then
+        curl -sSfL -o ${archive} ${url} || { echo "Error: could not download ${url}"; return 1; }
+    fi
+    sum=$(sha256sum ${archive} | cut -d' ' -f1)
+    recorded=$(grep " $(basename ${archive})$" sources.sha256 2>/dev/null | cut -d' ' -f1)
+    recorded3=$(grep " $(basename ${archive})$" sources.sha3-256 2>/dev/null | cut -d' ' -f1)
+    if [ -n "${recorded}" ]; then
+        if [ "${recorded}" != "${sum}" ]; then
+            echo "Error: ${archive} does not match sources.sha256"
+            return 1
+        fi
+    elif [ -n "${recorded3}" ]; then
+        sum3=$(openssl dgst -sha3-256 -r ${archive} | cut -d' ' -f1)
+        if [ "${recorded3}" != "${sum3}" ]; then
+            echo "Error: ${archive} does not match sources.sha3-256"
+            return 1
+        fi
+    elif [ "${pin}" -eq 1 ]; then
+        echo "Pinning ${archive} at ${sum}; check it against the upstream release"
+        echo "${sum} $(basename ${archive})" >> sources.sha256
+    else
+        echo "Error: ${archive} has no entry in sources.sha256 or sources.sha3-256 (SHA-256 ${sum})"
+        echo "Add the hash published with the release, or check it and pin it with -p"
+        return 1
+    fi
+    rm -rf ${work}/${name} && mkdir -p ${work}/${name}
+    case ${archive} in
+        *.zip) unzip -q -j ${archive} -d ${work}/${name};;
+        *) tar -xzf ${archive} -C ${work}/${name} --strip-components=1;;
+    esac
+}
+
+# Set sources, cflags, libs and the training and reference arguments of one program. The
+# arguments are run from this directory with the binary prepended.
+configure()
+{
+    case $1 in
+        sqlite)
+            fetch sqlite ${sqlite_url} || return 1
+            sources="${work}/sqlite/sqlite3.c ${work}/sqlite/shell.c"
+            cflags="-DSQLITE_THREADSAFE=0 -DSQLITE_OMIT_LOAD_EXTENSION"
+            libs="-lm"
+            train_args="-batch -init inputs/train.sql :memory: .quit"
+            ref_args="-batch -init inputs/ref.sql :memory: .quit";;
+        lua)
+            fetch lua ${lua_url} || return 1
+            sources=$(ls ${work}/lua/src/*.c | grep -v luac.c)
+            cflags="-DLUA_USE_POSIX"
+            libs="-lm"
+            train_args="inputs/train.lua"
+            ref_args="inputs/ref.lua";;
+        zlib)
+            fetch zlib ${zlib_url} || return 1
+            sources="$(ls ${work}/zlib/*.c) ${work}/zlib/test/minigzip.c"
+            cflags="-I${work}/zlib"
+            libs=""
+            # Compress zlib's own sources to train and its contrib/ tree as reference, so that
+            # both inputs come from the pinned archive
+            cat ${work}/zlib/*.c > ${work}/zlib/train.input
+            find ${work}/zlib/contrib -type f | LC_ALL=C sort | xargs cat > ${work}/zlib/ref.input
+            train_args="-c ${work}/zlib/train.input"
+            ref_args="-c ${work}/zlib/ref.input";;
+        *)
+            echo "Error: unknown program $1"
+            return 1;;
+    esac
+}
+
+skipped=""
+for program in ${programs}; do
+    if ! configure ${program}; then
+        echo ">> SKIP - ${program}"
+        skipped="${skipped} ${program}"
+        continue
+    fi
+    out=${work}/${program}.build
+    rm -rf ${out} && mkdir -p ${out}/bc
+
+    # Convert every source to bitcode (IR) and link them into one module
+    for source in ${sources}; do
+        clang -emit-llvm -Xclang -disable-O0-optnone ${cflags} -c ${source} -o ${out}/bc/$(basename ${source}).bc
+    done
+    llvm-link ${out}/bc/*.bc -o ${out}/${program}.bc
+
+    # Profile the training input
+    opt -enable-new-pm=0 -pgo-instr-gen -instrprof ${out}/${program}.bc -o ${out}/${program}.prof.bc
+    clang -fprofile-instr-generate ${out}/${program}.prof.bc ${libs} -o ${out}/${program}_prof
+    LLVM_PROFILE_FILE=${out}/${program}.profraw ./${out}/${program}_prof ${train_args} > /dev/null
+    llvm-profdata merge -o ${out}/${program}.profdata ${out}/${program}.profraw
+
+    # Use opt four times to compile with specific passes, as get_statistics.sh does
+    use_profile="-pgo-instr-use -pgo-test-profile-file=${out}/${program}.profdata"
+    opt -enable-new-pm=0 -o ${out}/${program}.none.bc ${use_profile} ${out}/${program}.bc
+    opt -enable-new-pm=0 -o ${out}/${program}.gvn.bc ${use_profile} -gvn -dce ${out}/${program}.bc
+    opt -enable-new-pm=0 -o ${out}/${program}.ispre.bc ${use_profile} -load ${llvm_library} -ispre -dce ${out}/${program}.bc
+    opt -enable-new-pm=0 -o ${out}/${program}.multiispre.bc ${use_profile} -load ${llvm_library} ${multipasses} -dce ${out}/${program}.bc
+    for variant in none gvn ispre multiispre; do
+        clang ${out}/${program}.${variant}.bc ${libs} -o ${out}/${program}_${variant}
+    done
+
+    echo -e "=== ${program} ==="
+    llvm-dis -o - ${out}/${program}.bc | awk '/^define/ { f++ } /^  [^ ;]/ { i++ } END { print ">> Module: " f " functions, " i " instructions" }'
+
+    # Produce output from every binary on the reference input to check correctness
+    ./${out}/${program}_none ${ref_args} > ${out}/correct_output
+    failed=0
+    for variant in gvn ispre multiispre; do
+        ./${out}/${program}_${variant} ${ref_args} > ${out}/${variant}_output
+        if ! cmp -s ${out}/correct_output ${out}/${variant}_output; then
+            echo ">> FAIL - ${variant}"
+            failed=1
+        fi
+    done
+    if [ "${failed}" -eq 1 ]; then
+        continue
+    fi
+    echo ">> PASS"
+
+    # End-to-end runtime on the reference input, and the compile time of the ISPRE
+    # configurations on the whole module
+    compile="opt -enable-new-pm=0 -o /dev/null ${use_profile} -load ${llvm_library}"
+    ${bench_tool} -runs ${runs} -warmup 1 -o ${program}.bench.json \
+        "none=./${out}/${program}_none ${ref_args}" "gvn=./${out}/${program}_gvn ${ref_args}" \
+        "ispre=./${out}/${program}_ispre ${ref_args}" "multiispre=./${out}/${program}_multiispre ${ref_args}" \
+        "compile_gvn=opt -enable-new-pm=0 -o /dev/null ${use_profile} -gvn -dce ${out}/${program}.bc" \
+        "compile_ispre=${compile} -ispre -dce ${out}/${program}.bc" \
+        "compile_multiispre=${compile} ${multipasses} -dce ${out}/${program}.bc"
+    echo
+
+    # Cleanup
+    if [ "$keep" -eq 0 ]; then
+        rm -rf ${out}
+    fi
+done
+
+if [ -n "${skipped}" ]; then
+    echo "Error: skipped${skipped}"
+    exit 1
+fi
@@ -0,0 +1,32 @@
+; -ispre-adaptive-threshold=coverage with block counts near UINT64_MAX. entry and exit run
+; 18000000000000000000 times, b1 and b2 just below that: their executions no longer fit a uint64_t
+; sum. Summed without wrapping, the hot chain covers 99.5% of them and the cut-off falls between
+; it and the cold block x; a wrapped sum put it between the two hottest counts (0.9938).
+;
+; RUN: opt -enable-new-pm=0 -load %ispre -ispre -ispre-adaptive-threshold=coverage -pass-remarks-analysis=ispre %s -o /dev/null 2>&1 | FileCheck %s
+;
+; CHECK: threshold of saturated set to 0.5000
+
+define i32 @saturated(i32 %a, i32 %b) !prof !0 {
+entry:
+  %c0 = icmp sgt i32 %a, 0
+  br i1 %c0, label %b1, label %x, !prof !1
+
+b1:
+  %c1 = icmp sgt i32 %b, 0
+  br i1 %c1, label %b2, label %x, !prof !1
+
+b2:
+  %m = mul i32 %a, %b
+  br label %exit
+
+x:
+  br label %exit
+
+exit:
+  %r = phi i32 [ %m, %b2 ], [ 0, %x ]
+  ret i32 %r
+}
+
+!0 = !{!"function_entry_count", i64 18000000000000000000}
+!1 = !{!"branch_weights", i32 99, i32 1}
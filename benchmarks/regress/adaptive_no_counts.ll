@@ -0,0 +1,24 @@
+; -ispre-adaptive-threshold on a function whose counts are all 0. chooseThreshold has nothing to
+; pick from and falls back to the stage's own threshold, which must not be scaled a second time
+; (0.45 * 0.45 / 0.9 for -ispre2).
+;
+; RUN: opt -enable-new-pm=0 -load %ispre -ispre -ispre2 -ispre-adaptive-threshold=gap -pass-remarks-analysis=ispre.* %s -o /dev/null 2>&1 | FileCheck %s
+;
+; CHECK: threshold of never set to 0.9000
+; CHECK-NEXT: threshold of never set to 0.4500
+
+define i32 @never(i32 %a, i32 %b) !prof !0 {
+entry:
+  %c = icmp sgt i32 %a, 0
+  br i1 %c, label %t, label %e
+
+t:
+  %x = mul i32 %a, %b
+  br label %e
+
+e:
+  %y = mul i32 %a, %b
+  ret i32 %y
+}
+
+!0 = !{!"function_entry_count", i64 0}
@@ -0,0 +1,26 @@
+; -ispre-bands on the IR of ispre_test1.ll, in a cascade of two passes. Only -ispre solves the
+; bands, one decision dump per boundary; -ispre2 runs once at its own threshold instead of
+; repeating every band.
+;
+; RUN: llvm-profdata merge %S/ispre_test1.proftext -o %t.profdata
+; RUN: rm -rf %t.json && mkdir %t.json
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.profdata -ispre -ispre2 -ispre-bands=0.9,0.45,0.22,0.11 -ispre-dump-json=%t.json -dce %S/ispre_test1.ll -o %t.bc
+; RUN: ls %t.json | FileCheck %s --check-prefix=FILES
+; RUN: FileCheck %s --check-prefix=BAND < %t.json/main.ispre.band4.json
+; RUN: FileCheck %s --check-prefix=STAGE2 < %t.json/main.ispre2.json
+; RUN: lli %t.bc | FileCheck %S/ispre_test1.ll --check-prefix=OUT
+;
+; FILES: main.ispre.band1.json
+; FILES-NEXT: main.ispre.band2.json
+; FILES-NEXT: main.ispre.band3.json
+; FILES-NEXT: main.ispre.band4.json
+; FILES-NEXT: main.ispre2.json
+; FILES-NOT: band
+;
+; BAND: "pass": "ispre",
+; BAND-NEXT: "threshold": 0.11,
+; BAND-NEXT: "band": 4,
+;
+; STAGE2: "pass": "ispre2",
+; STAGE2-NEXT: "threshold": 0.45000000000000001,
+; STAGE2-NEXT: "band": 0,
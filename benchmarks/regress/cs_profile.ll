@@ -0,0 +1,22 @@
+; Context-sensitive profiles, as get_statistics.sh -s builds them, on the IR of ispre_test1.ll.
+; cs_profile.proftext holds the counters of the first, pre-inline round of the -O1 pipeline and
+; cs_profile.cs.proftext those of the second, post-inline round. Only a build annotated from the
+; merged profile carries a CS profile summary, and only its functions are marked as classified
+; by a context-sensitive profile.
+;
+; RUN: llvm-profdata merge %S/cs_profile.proftext -o %t.profdata
+; RUN: llvm-profdata merge %S/cs_profile.proftext %S/cs_profile.cs.proftext -o %t.cs.profdata
+; RUN: opt -passes='default<O1>' -pgo-kind=pgo-instr-use-pipeline -profile-file=%t.profdata %S/ispre_test1.ll -o %t.plain.bc
+; RUN: opt -passes='default<O1>' -pgo-kind=pgo-instr-use-pipeline -profile-file=%t.cs.profdata -cspgo-kind=cspgo-instr-use-pipeline %S/ispre_test1.ll -o %t.cs.bc
+; RUN: rm -rf %t.json && mkdir %t.json %t.json/plain %t.json/cs
+; RUN: opt -enable-new-pm=0 -reg2mem %t.plain.bc | opt -enable-new-pm=0 -load %ispre -ispre -ispre-dump-json=%t.json/plain -o /dev/null
+; RUN: opt -enable-new-pm=0 -reg2mem %t.cs.bc | opt -enable-new-pm=0 -load %ispre -ispre -ispre-dump-json=%t.json/cs -o %t.bc
+; RUN: FileCheck %s --check-prefix=PLAIN < %t.json/plain/main.ispre.json
+; RUN: FileCheck %s --check-prefix=CS < %t.json/cs/main.ispre.json
+; RUN: lli %t.bc | FileCheck %S/ispre_test1.ll --check-prefix=OUT
+;
+; PLAIN: "staticEstimates": false,
+; PLAIN-NEXT: "contextSensitive": false,
+;
+; CS: "staticEstimates": false,
+; CS-NEXT: "contextSensitive": true,
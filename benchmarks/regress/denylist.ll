@@ -0,0 +1,98 @@
+; Deny list round trip on IR with unnamed values, through a two-stage cascade. The branch
+; weights claim if.else is the hot path, but the loop takes if.then 1023 times out of 1024,
+; so every speculation of a * b and a / b loses. The instrumented build numbers its values
+; differently from the next one; the sites in the counts must still match.
+;
+; RUN: opt -enable-new-pm=0 -load %ispre -ispre -ispre2 -ispre-instrument -dce %s -o %t.counted.bc
+; RUN: llc -filetype=obj -relocation-model=pic %t.counted.bc -o %t.counted.o
+; RUN: cc %t.counted.o %build/runtime/libispre_rt.a -o %t.counted
+; RUN: ISPRE_COUNTS_FILE=%t.counts %t.counted | FileCheck %s --check-prefix=OUT
+; RUN: rm -f %t.denylist
+; RUN: %build/tools/ispre-denylist/ispre-denylist -o %t.denylist %t.counts > /dev/null
+; RUN: FileCheck %s --check-prefix=LIST < %t.denylist
+; RUN: opt -enable-new-pm=0 -load %ispre -ispre -ispre2 -ispre-deny-list=%t.denylist -dce -pass-remarks=ispre.* -pass-remarks-missed=ispre.* %s -o %t.bc 2>&1 | FileCheck %s --check-prefix=DENY
+; RUN: lli %t.bc | FileCheck %s --check-prefix=OUT
+;
+; OUT: Checksum: 1262914
+; LIST: main ispre2:if.else:0 %mul = mul nsw i32
+; LIST: main ispre2:if.else:1 %div = sdiv i32
+; LIST: main ispre:if.else:0 %mul = mul nsw i32 %3, %4
+; LIST: main ispre:if.else:1 %div = sdiv i32 %5, %6
+; DENY-NOT: :0: speculated
+; DENY: not speculated %mul = mul nsw i32 %3, %4: deny-listed
+; DENY: not speculated %div = sdiv i32 %5, %6: deny-listed
+; DENY: not speculated %mul = mul nsw i32 %3, %4: deny-listed
+; DENY: not speculated %div = sdiv i32 %5, %6: deny-listed
+; DENY-NOT: :0: speculated
+
+@.str = private unnamed_addr constant [14 x i8] c"Checksum: %d\0A\00", align 1
+@acc = dso_local global i32 0, align 4
+
+define dso_local void @sink(i32 %0) noinline {
+entry:
+  %1 = load volatile i32, i32* @acc, align 4
+  %2 = xor i32 %1, %0
+  store volatile i32 %2, i32* @acc, align 4
+  ret void
+}
+
+define dso_local i32 @main() !prof !0 {
+entry:
+  %a = alloca i32, align 4
+  %b = alloca i32, align 4
+  %i = alloca i32, align 4
+  store i32 7, i32* %a, align 4
+  store i32 3, i32* %b, align 4
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:
+  %0 = load i32, i32* %i, align 4
+  %cmp = icmp slt i32 %0, 1000000
+  br i1 %cmp, label %for.body, label %for.end, !prof !1
+
+for.body:
+  %1 = load i32, i32* %i, align 4
+  %and = and i32 %1, 1023
+  %tobool = icmp ne i32 %and, 0
+  br i1 %tobool, label %if.then, label %if.else, !prof !2
+
+if.then:
+  %2 = load i32, i32* %i, align 4
+  store i32 %2, i32* %a, align 4
+  br label %for.inc
+
+if.else:
+  %3 = load i32, i32* %a, align 4
+  %4 = load i32, i32* %b, align 4
+  %mul = mul nsw i32 %3, %4
+  %5 = load i32, i32* %a, align 4
+  %6 = load i32, i32* %b, align 4
+  %div = sdiv i32 %5, %6
+  call void @sink(i32 %mul)
+  call void @sink(i32 %div)
+  br label %for.inc
+
+for.inc:
+  %7 = load i32, i32* %i, align 4
+  %call = call i32 @next(i32 %7)
+  store i32 %call, i32* %i, align 4
+  br label %for.cond
+
+for.end:
+  %8 = load volatile i32, i32* @acc, align 4
+  %call1 = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([14 x i8], [14 x i8]* @.str, i64 0, i64 0), i32 %8)
+  ret i32 0
+}
+
+define dso_local i32 @next(i32 %0) noinline {
+entry:
+  %1 = add nsw i32 %0, 1
+  ret i32 %1
+}
+
+declare i32 @printf(i8*, ...)
+
+!0 = !{!"function_entry_count", i64 1}
+!1 = !{!"branch_weights", i32 1000000, i32 1}
+!2 = !{!"branch_weights", i32 977, i32 999023}
@@ -0,0 +1,54 @@
+; -ispre-dump-json and -ispre-dump-dot on the IR of ispre_test1.ll. Each writes one file per
+; function and pass, with the inputs and results of the pass from before the IR changes: the
+; hot if.else is where a * a is removed, and the cold edges into the loop and out of if.then
+; are where it is inserted. Dumping must not change the IR the pass emits.
+;
+; RUN: llvm-profdata merge %S/ispre_test1.proftext -o %t.profdata
+; RUN: rm -rf %t.json %t.dot && mkdir %t.json %t.dot
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.profdata -ispre -ispre-dump-json=%t.json -ispre-dump-dot=%t.dot %S/ispre_test1.ll -o %t.dump.bc
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.profdata -ispre %S/ispre_test1.ll -o %t.bc
+; RUN: cmp %t.dump.bc %t.bc
+; RUN: ls %t.json %t.dot | FileCheck %s --check-prefix=FILES
+; RUN: FileCheck %s --check-prefix=JSON < %t.json/main.ispre.json
+; RUN: FileCheck %s --check-prefix=DOT < %t.dot/main.ispre.dot
+;
+; FILES: main.ispre.dot
+; FILES: main.ispre.json
+;
+; JSON: "function": "main",
+; JSON-NEXT: "pass": "ispre",
+; JSON-NEXT: "threshold": 0.9
+; JSON-NEXT: "band": 0,
+; JSON-NEXT: "maxCount": 9988296,
+; JSON: "name": "if.else",
+; JSON-NEXT: "count": 9988245,
+; JSON-NEXT: "relativeCount": 0.9999
+; JSON-NEXT: "hot": true,
+; JSON-NEXT: "xUses": [
+; JSON-NEXT: "%mul = mul nsw i64 %3, %4",
+; JSON: "removable": [
+; JSON-NEXT: "%mul = mul nsw i64 %3, %4"
+; JSON-NEXT: ],
+; JSON: "edges": [
+; JSON: "from": "entry",
+; JSON-NEXT: "to": "for.cond",
+; JSON-NEXT: "count": 1,
+; JSON-NEXT: "hot": false,
+; JSON-NEXT: "ingress": true
+; JSON: "inserts": [
+; JSON-NEXT: {
+; JSON-NEXT: "from": "entry",
+; JSON-NEXT: "to": "for.cond",
+; JSON-NEXT: "expressions": [
+; JSON-NEXT: "%mul = mul nsw i64 %3, %4"
+; JSON: "from": "if.then",
+; JSON-NEXT: "to": "if.end",
+; JSON-NEXT: "expressions": [
+; JSON-NEXT: "%mul = mul nsw i64 %3, %4"
+;
+; DOT: digraph "main (ispre, threshold 0.90)" {
+; DOT: "if.then" [label="if.then\ncount 50 (cold)\l"
+; DOT: "if.else" [label="if.else\ncount 9988245 (hot)\lremoved: %mul = mul nsw i64 %3, %4\l"
+; DOT: "entry" -> "for.cond" [label="1 (ingress)\linsert: %mul = mul nsw i64 %3, %4\l", color=red
+; DOT: "for.body" -> "if.then" [label="49", style=dashed
+; DOT: "if.then" -> "if.end" [label="50 (ingress)\linsert: %mul = mul nsw i64 %3, %4\l", color=red
@@ -0,0 +1,92 @@
+; ispre_test1.c as clang -O0 -Xclang -disable-O0-optnone emits it, with the loop shortened to
+; 10^7 iterations. ispre_test1.proftext holds the counters of that run.
+;
+; Plain -ispre must speculate a * a out of the loop: BFI rounds the loop count to 9988295,
+; just below the 99% hot count of the profile summary (9999950), so the module-wide check of
+; -ispre-hot-percentile must stay off by default.
+;
+; RUN: llvm-profdata merge %S/ispre_test1.proftext -o %t.profdata
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.profdata -ispre -dce -pass-remarks=ispre -pass-remarks-output=%t.yaml %s -o %t.default.bc 2>&1 | FileCheck %s --check-prefix=SPEC
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.profdata -ispre -ispre-hot-percentile=0 -dce %s -o %t.baseline.bc
+; RUN: cmp %t.default.bc %t.baseline.bc
+; RUN: lli %t.default.bc | FileCheck %s --check-prefix=OUT
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.profdata -ispre -ispre2 -ispre3 -ispre4 -ispre-adaptive-threshold=coverage -pass-remarks-analysis=ispre.* %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=ADAPT
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.profdata -ispre3 -ispre4 -ispre-adaptive-threshold=coverage -pass-remarks-analysis=ispre3 %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=STAGE3
+; RUN: opt -enable-new-pm=0 -pgo-instr-use -pgo-test-profile-file=%t.profdata %s -o %t.none.bc
+; RUN: %build/tools/ispre-remarks/ispre-remarks -profiled-ir %t.none.bc %t.yaml | FileCheck %s --check-prefix=REPORT
+;
+; Remarks name values by the slots of the input IR, not of the IR the pass has changed
+; SPEC: remark: {{.*}}speculated %mul = mul nsw i64 %3, %4 on ingress edge
+; SPEC: remark: {{.*}}replaced %mul = mul nsw i64 %3, %4 in if.else
+; OUT: Result: 9803733746937622528
+;
+; The speculated clones are charged with the counts of their source blocks, and the entry
+; count of main comes from the annotated IR, not from the first counter of the profile
+; REPORT: Estimated dynamic expressions speculatively added: 51
+; REPORT: 9988194 9988245 51 1 2 1 20.00% main
+;
+; The adaptive cut-off is picked for -ispre and scaled by each stage's own threshold
+; ADAPT: threshold of main set to 0.5000
+; ADAPT-NEXT: threshold of main set to 0.2500
+; ADAPT-NEXT: threshold of main set to 0.0611
+; ADAPT-NEXT: threshold of main set to 0.1222
+;
+; Remarks of a stage are named after the pass that emits them: -ispre3 runs at 0.11
+; STAGE3: threshold of main set to 0.0611
+; STAGE3-NOT: threshold of main
+@.str = private unnamed_addr constant [14 x i8] c"Result: %llu\0A\00", align 1
+
+define dso_local i32 @main() {
+entry:
+  %retval = alloca i32, align 4
+  %a = alloca i64, align 8
+  %sum = alloca i64, align 8
+  %i = alloca i32, align 4
+  store i32 0, i32* %retval, align 4
+  store i64 0, i64* %a, align 8
+  store i64 0, i64* %sum, align 8
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:
+  %0 = load i32, i32* %i, align 4
+  %cmp = icmp slt i32 %0, 10000000
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %1 = load i32, i32* %i, align 4
+  %rem = srem i32 %1, 200000
+  %cmp1 = icmp eq i32 %rem, 0
+  br i1 %cmp1, label %if.then, label %if.else
+
+if.then:
+  %2 = load i32, i32* %i, align 4
+  %conv = sext i32 %2 to i64
+  store i64 %conv, i64* %a, align 8
+  br label %if.end
+
+if.else:
+  %3 = load i64, i64* %a, align 8
+  %4 = load i64, i64* %a, align 8
+  %mul = mul nsw i64 %3, %4
+  %5 = load i64, i64* %sum, align 8
+  %add = add nsw i64 %5, %mul
+  store i64 %add, i64* %sum, align 8
+  br label %if.end
+
+if.end:
+  br label %for.inc
+
+for.inc:
+  %6 = load i32, i32* %i, align 4
+  %inc = add nsw i32 %6, 1
+  store i32 %inc, i32* %i, align 4
+  br label %for.cond
+
+for.end:
+  %7 = load i64, i64* %sum, align 8
+  %call = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([14 x i8], [14 x i8]* @.str, i64 0, i64 0), i64 %7)
+  ret i32 0
+}
+
+declare i32 @printf(i8*, ...)
@@ -0,0 +1,42 @@
+; Classification with counts above 2^41, on the IR of ispre_test1.ll. large_counts.proftext is
+; ispre_test1.proftext with if.else at 21990232555519950 (about 10000 * 2^41) and the other
+; counters scaled by 1000. Counts this large wrapped when they were kept in int; the hot
+; region and the speculation must come out the same as with the real profile.
+;
+; RUN: llvm-profdata merge %S/large_counts.proftext -o %t.profdata
+; RUN: rm -rf %t.json && mkdir %t.json
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.profdata -ispre -dce -ispre-dump-json=%t.json -pass-remarks=ispre %S/ispre_test1.ll -o %t.bc 2>&1 | FileCheck %s --check-prefix=SPEC
+; RUN: FileCheck %s --check-prefix=JSON < %t.json/main.ispre.json
+; RUN: lli %t.bc | FileCheck %s --check-prefix=OUT
+;
+; SPEC: speculated %mul = mul nsw i64 %3, %4 on ingress edge entry -> for.cond (edge count 10240000, source count 10240000)
+; SPEC: replaced %mul = mul nsw i64 %3, %4 in if.else {{.*}}(block count 21990232542720000)
+; SPEC: speculated %mul = mul nsw i64 %3, %4 on ingress edge if.then -> if.end (edge count 10240000, source count 10240000)
+;
+; JSON: "maxCount": 21990232563200000,
+; JSON-LABEL: "name": "entry",
+; JSON: "hot": false,
+; JSON-LABEL: "name": "for.cond",
+; JSON: "relativeCount": 1,
+; JSON: "hot": true,
+; JSON-LABEL: "name": "for.body",
+; JSON: "hot": true,
+; JSON-LABEL: "name": "if.then",
+; JSON: "hot": false,
+; JSON-LABEL: "name": "if.else",
+; JSON: "count": 21990232542720000,
+; JSON: "hot": true,
+; JSON-LABEL: "name": "for.end",
+; JSON: "hot": false,
+; JSON-LABEL: "edges": [
+; JSON: "to": "if.else",
+; JSON-NEXT: "count": 21990232552960000,
+; JSON-NEXT: "hot": true,
+; JSON: "from": "if.then",
+; JSON-NEXT: "to": "if.end",
+; JSON-NEXT: "count": 10240000,
+; JSON-NEXT: "hot": false,
+; JSON-NEXT: "ingress": true
+;
+; The program itself runs the 10^7 iterations of ispre_test1.ll
+; OUT: Result: 9803733746937622528
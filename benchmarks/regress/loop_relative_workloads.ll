@@ -0,0 +1,101 @@
+; -ispre-loop-relative with -ispre-workloads metadata. cold.cond loops 10000 times after a hot loop
+; of 10^6 iterations, so its body is cold relative to the hottest block but hot relative to its
+; own header. The !ispre.workloads counts are recorded relative to the hottest block too; the
+; workload check has to rescale them to the header as well, or it vetoes the hot inner region
+; that loop-relative mode finds. Without the mode the body stays cold.
+;
+; RUN: opt -enable-new-pm=0 -load %ispre -ispre -ispre-loop-relative -pass-remarks=ispre %s -o %t.bc 2>&1 | FileCheck %s --check-prefix=LOOP
+; RUN: opt -enable-new-pm=0 -load %ispre -ispre -pass-remarks-missed=ispre %s -o %t.bc 2>&1 | FileCheck %s --check-prefix=FUNC
+;
+; LOOP: speculated %mul = mul nsw i64 %5, %6 on ingress edge cold.then -> cold.inc (edge count 10, source count 10)
+; LOOP: replaced %mul = mul nsw i64 %5, %6 in cold.else with value speculated on ingress edge cold.then -> cold.inc (block count 9990)
+; LOOP: speculated %mul = mul nsw i64 %5, %6 on ingress edge mid -> cold.cond (edge count 1, source count 1)
+;
+; FUNC: not speculated %mul = mul nsw i64 %5, %6: use site cold.else is cold (count 9990)
+
+define i64 @loops(i64 %x, i64 %y, i64 %n) !prof !0 {
+entry:
+  %a = alloca i64, align 8
+  %b = alloca i64, align 8
+  %sum = alloca i64, align 8
+  %i = alloca i64, align 8
+  %j = alloca i64, align 8
+  store i64 %x, i64* %a, align 8
+  store i64 %y, i64* %b, align 8
+  store i64 0, i64* %sum, align 8
+  store i64 0, i64* %i, align 8
+  br label %hot.cond, !ispre.workloads !10
+
+hot.cond:
+  %0 = load i64, i64* %i, align 8
+  %cmp = icmp slt i64 %0, 1000000
+  br i1 %cmp, label %hot.body, label %mid, !prof !1, !ispre.workloads !11
+
+hot.body:
+  %1 = load i64, i64* %i, align 8
+  %inc = add nsw i64 %1, 1
+  store i64 %inc, i64* %i, align 8
+  br label %hot.cond, !ispre.workloads !12
+
+mid:
+  store i64 0, i64* %j, align 8
+  br label %cold.cond, !ispre.workloads !13
+
+cold.cond:
+  %2 = load i64, i64* %j, align 8
+  %cmp1 = icmp slt i64 %2, %n
+  br i1 %cmp1, label %cold.body, label %exit, !prof !2, !ispre.workloads !14
+
+cold.body:
+  %3 = load i64, i64* %j, align 8
+  %rem = srem i64 %3, 1000
+  %cmp2 = icmp eq i64 %rem, 0
+  br i1 %cmp2, label %cold.then, label %cold.else, !prof !3, !ispre.workloads !15
+
+cold.then:
+  %4 = load i64, i64* %j, align 8
+  store i64 %4, i64* %a, align 8
+  br label %cold.inc, !ispre.workloads !16
+
+cold.else:
+  %5 = load i64, i64* %a, align 8
+  %6 = load i64, i64* %b, align 8
+  %mul = mul nsw i64 %5, %6
+  %7 = load i64, i64* %sum, align 8
+  %add = add nsw i64 %7, %mul
+  store i64 %add, i64* %sum, align 8
+  br label %cold.inc, !ispre.workloads !17
+
+cold.inc:
+  %8 = load i64, i64* %j, align 8
+  %inc3 = add nsw i64 %8, 1
+  store i64 %inc3, i64* %j, align 8
+  br label %cold.cond, !ispre.workloads !18
+
+exit:
+  %9 = load i64, i64* %sum, align 8
+  ret i64 %9
+}
+
+!0 = !{!"function_entry_count", i64 1}
+!1 = !{!"branch_weights", i32 1000000, i32 1}
+!2 = !{!"branch_weights", i32 10000, i32 1}
+!3 = !{!"branch_weights", i32 1, i32 1000}
+!10 = !{!20}
+!11 = !{!21}
+!12 = !{!22}
+!13 = !{!23}
+!14 = !{!24}
+!15 = !{!25}
+!16 = !{!26}
+!17 = !{!27}
+!18 = !{!28}
+!20 = !{double 1.0, double 1.0e-6, double 1.0e-6}
+!21 = !{double 1.0, double 1.0, double 1.0, double 1.0e-6}
+!22 = !{double 1.0, double 1.0, double 1.0}
+!23 = !{double 1.0, double 1.0e-6, double 1.0e-6}
+!24 = !{double 1.0, double 1.0e-2, double 1.0e-2, double 1.0e-6}
+!25 = !{double 1.0, double 1.0e-2, double 1.0e-5, double 9.99e-3}
+!26 = !{double 1.0, double 1.0e-5, double 1.0e-5}
+!27 = !{double 1.0, double 9.99e-3, double 9.99e-3}
+!28 = !{double 1.0, double 1.0e-2, double 1.0e-2}
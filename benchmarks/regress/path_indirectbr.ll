@@ -0,0 +1,47 @@
+; Path profiling of a function with an indirectbr. Its edge to b is critical, and splitting it
+; would leave the block address of b jumping past the new block that adds the edge's value, so
+; the function is left uninstrumented; the other functions of the module still get their
+; counters.
+;
+; RUN: opt -S -enable-new-pm=0 -load %ispre -ispre-path-profile-gen %s -o %t.ll
+; RUN: FileCheck %s --check-prefix=IR < %t.ll
+;
+; IR-LABEL: define i32 @g(
+; IR-NOT: ispre.path
+; IR: indirectbr i8* %target, [label %a, label %b]
+; IR-NOT: ispre.path
+; IR-LABEL: define i32 @f(
+; IR: %ispre.path = alloca i64
+
+@targets = constant [2 x i8*] [i8* blockaddress(@g, %a), i8* blockaddress(@g, %b)]
+
+define i32 @g(i64 %x) {
+entry:
+  %slot = getelementptr [2 x i8*], [2 x i8*]* @targets, i64 0, i64 %x
+  %target = load i8*, i8** %slot
+  indirectbr i8* %target, [label %a, label %b]
+
+a:
+  %c = icmp eq i64 %x, 0
+  br i1 %c, label %b, label %done
+
+b:
+  br label %done
+
+done:
+  %r = phi i32 [ 1, %a ], [ 2, %b ]
+  ret i32 %r
+}
+
+define i32 @f(i32 %x) {
+entry:
+  %c = icmp sgt i32 %x, 0
+  br i1 %c, label %t, label %e
+
+t:
+  br label %e
+
+e:
+  %r = phi i32 [ 1, %t ], [ 0, %entry ]
+  ret i32 %r
+}
@@ -0,0 +1,88 @@
+; Path profiling of a switch whose cases 1 and 2 share a target that has another predecessor.
+; The numbering counts the two cases as one edge, so splitting it must send both through the
+; block that adds the edge's value; before, case 2 bypassed it and its paths were counted as
+; sw -> d.
+;
+; RUN: opt -S -enable-new-pm=0 -load %ispre -ispre-path-profile-gen %s -o %t.ll
+; RUN: FileCheck %s --check-prefix=IR < %t.ll
+; RUN: llc -filetype=obj -relocation-model=pic %t.ll -o %t.o
+; RUN: cc %t.o %build/runtime/libispre_rt.a -o %t
+; RUN: ISPRE_PATHS_FILE=%t.paths %t
+; RUN: FileCheck %s --check-prefix=PATHS < %t.paths
+;
+; IR-LABEL: define i32 @f(
+; IR: switch i32 %x, label %d [
+; IR-NEXT: i32 1, label %[[SPLIT:.*]]
+; IR-NEXT: i32 2, label %[[SPLIT]]
+; IR-NEXT: i32 3, label %b
+; IR: [[SPLIT]]:
+; IR-NEXT: load i64, i64* %ispre.path
+; IR-NEXT: add i64 %{{.*}}, 1
+; IR-LABEL: define i32 @g(
+; IR: switch i32 %x, label %d [
+; IR-NEXT: i32 1, label %a
+; IR-NEXT: i32 2, label %a
+; IR: a:
+; IR-NEXT: load i64, i64* %ispre.path
+;
+; Paths of f: 0 sw -> d, 1 sw -> a, 2 sw -> b, 3 entry -> a
+; PATHS-DAG: f 4 0 1
+; PATHS-DAG: f 4 1 5
+; PATHS-DAG: f 4 2 1
+; PATHS-DAG: f 4 3 1
+
+define i32 @f(i32 %x, i1 %c) {
+entry:
+  br i1 %c, label %sw, label %a
+
+sw:
+  switch i32 %x, label %d [
+    i32 1, label %a
+    i32 2, label %a
+    i32 3, label %b
+  ]
+
+a:
+  br label %d
+
+b:
+  br label %d
+
+d:
+  %r = phi i32 [ 0, %sw ], [ 1, %a ], [ 2, %b ]
+  ret i32 %r
+}
+
+; The same switch when the shared target has no other predecessor: nothing is split
+define i32 @g(i32 %x) {
+entry:
+  switch i32 %x, label %d [
+    i32 1, label %a
+    i32 2, label %a
+    i32 3, label %b
+  ]
+
+a:
+  br label %d
+
+b:
+  br label %d
+
+d:
+  %r = phi i32 [ 0, %entry ], [ 1, %a ], [ 2, %b ]
+  ret i32 %r
+}
+
+define i32 @main() {
+entry:
+  %0 = call i32 @f(i32 1, i1 true)
+  %1 = call i32 @f(i32 1, i1 true)
+  %2 = call i32 @f(i32 1, i1 true)
+  %3 = call i32 @f(i32 2, i1 true)
+  %4 = call i32 @f(i32 2, i1 true)
+  %5 = call i32 @f(i32 3, i1 true)
+  %6 = call i32 @f(i32 0, i1 true)
+  %7 = call i32 @f(i32 2, i1 false)
+  %8 = call i32 @g(i32 2)
+  ret i32 0
+}
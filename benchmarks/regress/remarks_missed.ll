@@ -0,0 +1,97 @@
+; Missed opportunities in the ispre-remarks report. With two bands the pass reports a site of
+; the cold loop once per band, cold at the first boundary and killed at the second; the report
+; lists every site once, with its highest use count and both reasons. Remarks of the helper
+; passes whose names start with "ispre" stay out of the report unless -passes names them.
+;
+; RUN: opt -enable-new-pm=0 -load %ispre -ispre -ispre-bands=0.9,0.005 -pass-remarks-output=%t.yaml %s -o /dev/null
+; RUN: %build/tools/ispre-remarks/ispre-remarks %t.yaml | FileCheck %s --check-prefix=BANDS
+; RUN: opt -enable-new-pm=0 -load %ispre -ispre-stale-profile -ispre-profile-snapshot=%S/stale_profile.blocks.json -ispre-stale-min-match=2 -ispre -pass-remarks-output=%t.stale.yaml %S/stale_profile.ll -o /dev/null
+; RUN: %build/tools/ispre-remarks/ispre-remarks %t.stale.yaml | FileCheck %s --check-prefix=CASCADE
+; RUN: %build/tools/ispre-remarks/ispre-remarks -passes=ispre-stale-profile %t.stale.yaml | FileCheck %s --check-prefix=STALE
+;
+; BANDS-LABEL: Biggest missed opportunities
+; BANDS-NEXT: Count Reason
+; BANDS-NEXT: 1000224 KilledInHotRegion loops @ <unknown>: %inc = add nsw i64 %1, 1
+; BANDS-NEXT: 10000 ColdUseSite,KilledInHotRegion loops @ <unknown>: %rem = srem i64 %3, 1000
+; BANDS-NEXT: 10000 ColdUseSite,KilledInHotRegion loops @ <unknown>: %inc3 = add nsw i64 %8, 1
+; BANDS-NEXT: 9990 ColdUseSite loops @ <unknown>: %mul = mul nsw i64 %5, %6
+; BANDS-NEXT: 9990 ColdUseSite,KilledInHotRegion loops @ <unknown>: %add = add nsw i64 %7, %mul
+; BANDS-NOT: loops
+;
+; CASCADE-LABEL: Biggest missed opportunities
+; CASCADE-NOT: StaleProfileUnmatched
+; CASCADE: 0 NoProfile f @ <unknown>:
+; CASCADE-NOT: StaleProfileUnmatched
+;
+; STALE-LABEL: Biggest missed opportunities
+; STALE-NOT: NoProfile
+; STALE: 0 StaleProfileUnmatched f @ <unknown>:
+
+define i64 @loops(i64 %x, i64 %y, i64 %n) !prof !0 {
+entry:
+  %a = alloca i64, align 8
+  %b = alloca i64, align 8
+  %sum = alloca i64, align 8
+  %i = alloca i64, align 8
+  %j = alloca i64, align 8
+  store i64 %x, i64* %a, align 8
+  store i64 %y, i64* %b, align 8
+  store i64 0, i64* %sum, align 8
+  store i64 0, i64* %i, align 8
+  br label %hot.cond
+
+hot.cond:
+  %0 = load i64, i64* %i, align 8
+  %cmp = icmp slt i64 %0, 1000000
+  br i1 %cmp, label %hot.body, label %mid, !prof !1
+
+hot.body:
+  %1 = load i64, i64* %i, align 8
+  %inc = add nsw i64 %1, 1
+  store i64 %inc, i64* %i, align 8
+  br label %hot.cond
+
+mid:
+  store i64 0, i64* %j, align 8
+  br label %cold.cond
+
+cold.cond:
+  %2 = load i64, i64* %j, align 8
+  %cmp1 = icmp slt i64 %2, %n
+  br i1 %cmp1, label %cold.body, label %exit, !prof !2
+
+cold.body:
+  %3 = load i64, i64* %j, align 8
+  %rem = srem i64 %3, 1000
+  %cmp2 = icmp eq i64 %rem, 0
+  br i1 %cmp2, label %cold.then, label %cold.else, !prof !3
+
+cold.then:
+  %4 = load i64, i64* %j, align 8
+  store i64 %4, i64* %a, align 8
+  br label %cold.inc
+
+cold.else:
+  %5 = load i64, i64* %a, align 8
+  %6 = load i64, i64* %b, align 8
+  %mul = mul nsw i64 %5, %6
+  %7 = load i64, i64* %sum, align 8
+  %add = add nsw i64 %7, %mul
+  store i64 %add, i64* %sum, align 8
+  br label %cold.inc
+
+cold.inc:
+  %8 = load i64, i64* %j, align 8
+  %inc3 = add nsw i64 %8, 1
+  store i64 %inc3, i64* %j, align 8
+  br label %cold.cond
+
+exit:
+  %9 = load i64, i64* %sum, align 8
+  ret i64 %9
+}
+
+!0 = !{!"function_entry_count", i64 1}
+!1 = !{!"branch_weights", i32 1000000, i32 1}
+!2 = !{!"branch_weights", i32 10000, i32 1}
+!3 = !{!"branch_weights", i32 1, i32 1000}
@@ -0,0 +1,44 @@
+; Stale profile recovery after @f gained blocks %k and %n. stale_profile.blocks.json is the
+; snapshot -ispre-profile-snapshot-out wrote for the old @f, in which entry went to %a 10 times
+; and to %j 89 times, and %a always went on to %j.
+;
+; RUN: opt -S -enable-new-pm=0 -load %ispre -ispre-stale-profile -ispre-profile-snapshot=%S/stale_profile.blocks.json -pass-remarks-analysis=ispre-stale-profile %s -o %t.ll 2>&1 | FileCheck %s --check-prefix=REMARK
+; RUN: FileCheck %s < %t.ll
+;
+; REMARK: recovered the stale profile of f: 3 of 5 blocks matched, entry count 100
+;
+; The entry branch kept its successors, so it keeps its recorded edge counts. Weighting it by
+; the counts of its targets would send everything to %a, since the new %n has no count of its
+; own to start from.
+; CHECK: br i1 %c, label %a, label %n, !prof ![[ENTRY:[0-9]+]]
+; %a now branches, so its weights are inferred: no more than the 10 it executes goes to %j,
+; and %k, which nothing recorded reaches, gets nothing
+; CHECK: br i1 %d, label %j, label %k, !prof ![[A:[0-9]+]]
+; CHECK: ![[ENTRY]] = !{!"branch_weights", i32 10, i32 89}
+; CHECK: ![[A]] = !{!"branch_weights", i32 10, i32 0}
+
+declare void @foo()
+declare void @bar()
+declare void @baz()
+
+define void @f(i1 %c, i1 %d) {
+entry:
+  br i1 %c, label %a, label %n
+
+a:
+  call void @foo()
+  br i1 %d, label %j, label %k
+
+k:
+  call void @baz()
+  call void @baz()
+  br label %j
+
+n:
+  call void @baz()
+  br label %j
+
+j:
+  call void @bar()
+  ret void
+}
@@ -0,0 +1,81 @@
+; Builds without a profile, on ispre_test1.ll with the rare branch of the loop marked by
+; __builtin_expect. Without -ispre-static-profile the function is skipped. With it, the
+; static estimates of BlockFrequencyInfo classify the blocks; once -lower-expect has turned the
+; hint into branch weights, if.else is hot and a * a is speculated out of the loop. Without the
+; hint the two arms look alike and if.else stays cold. Past -ispre-static-max-inserts the
+; function is left alone.
+;
+; RUN: opt -enable-new-pm=0 -load %ispre -lower-expect -ispre -pass-remarks-missed=ispre %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=NONE
+; RUN: opt -enable-new-pm=0 -load %ispre -lower-expect -ispre -ispre-static-profile -pass-remarks=ispre %s -o %t.bc 2>&1 | FileCheck %s --check-prefix=HINT
+; RUN: lli %t.bc | FileCheck %S/ispre_test1.ll --check-prefix=OUT
+; RUN: opt -enable-new-pm=0 -load %ispre -ispre -ispre-static-profile -pass-remarks-missed=ispre %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=NOHINT
+; RUN: opt -enable-new-pm=0 -load %ispre -lower-expect -ispre -ispre-static-profile -ispre-static-max-inserts=1 -pass-remarks-missed=ispre %s -o /dev/null 2>&1 | FileCheck %s --check-prefix=CAP
+;
+; NONE: function main has no profile (use -ispre-static-profile to estimate one)
+;
+; HINT: speculated %mul = mul nsw i64 %3, %4 on ingress edge entry -> for.cond
+; HINT-NEXT: replaced %mul = mul nsw i64 %3, %4 in if.else
+;
+; NOHINT: not speculated %mul = mul nsw i64 %3, %4: use site if.else is cold
+;
+; CAP: not speculated in main: {{[0-9]+}} insertions exceed the cap of 1 for static estimates
+
+@.str = private unnamed_addr constant [14 x i8] c"Result: %llu\0A\00", align 1
+
+define dso_local i32 @main() {
+entry:
+  %retval = alloca i32, align 4
+  %a = alloca i64, align 8
+  %sum = alloca i64, align 8
+  %i = alloca i32, align 4
+  store i32 0, i32* %retval, align 4
+  store i64 0, i64* %a, align 8
+  store i64 0, i64* %sum, align 8
+  store i32 0, i32* %i, align 4
+  br label %for.cond
+
+for.cond:
+  %0 = load i32, i32* %i, align 4
+  %cmp = icmp slt i32 %0, 10000000
+  br i1 %cmp, label %for.body, label %for.end
+
+for.body:
+  %1 = load i32, i32* %i, align 4
+  %rem = srem i32 %1, 200000
+  %cmp1 = icmp eq i32 %rem, 0
+  %expval = call i1 @llvm.expect.i1(i1 %cmp1, i1 false)
+  br i1 %expval, label %if.then, label %if.else
+
+if.then:
+  %2 = load i32, i32* %i, align 4
+  %conv = sext i32 %2 to i64
+  store i64 %conv, i64* %a, align 8
+  br label %if.end
+
+if.else:
+  %3 = load i64, i64* %a, align 8
+  %4 = load i64, i64* %a, align 8
+  %mul = mul nsw i64 %3, %4
+  %5 = load i64, i64* %sum, align 8
+  %add = add nsw i64 %5, %mul
+  store i64 %add, i64* %sum, align 8
+  br label %if.end
+
+if.end:
+  br label %for.inc
+
+for.inc:
+  %6 = load i32, i32* %i, align 4
+  %inc = add nsw i32 %6, 1
+  store i32 %inc, i32* %i, align 4
+  br label %for.cond
+
+for.end:
+  %7 = load i64, i64* %sum, align 8
+  %call = call i32 (i8*, ...) @printf(i8* getelementptr inbounds ([14 x i8], [14 x i8]* @.str, i64 0, i64 0), i64 %7)
+  ret i32 0
+}
+
+declare i32 @printf(i8*, ...)
+
+declare i1 @llvm.expect.i1(i1, i1)
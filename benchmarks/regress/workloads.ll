@@ -0,0 +1,20 @@
+; Per-workload hotness (-ispre-workloads) on the IR of ispre_test1.ll. Workload a is
+; ispre_test1.proftext, where the loop almost always takes if.else; workload b
+; (workloads_b.proftext) swaps the counts of if.then and if.else. The passes are fed a's
+; profile in both runs. When b carries three quarters of the weight, if.else is hot under less
+; than the default quorum of half the weight, so a * a stays in it; when a does, it is
+; speculated out of the loop as with a's profile alone.
+;
+; RUN: llvm-profdata merge %S/ispre_test1.proftext -o %t.a.profdata
+; RUN: llvm-profdata merge %S/workloads_b.proftext -o %t.b.profdata
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.a.profdata -ispre-stale-profile -ispre-profile-snapshot-out=%t.a.json %S/ispre_test1.ll -o /dev/null
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.b.profdata -ispre-stale-profile -ispre-profile-snapshot-out=%t.b.json %S/ispre_test1.ll -o /dev/null
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.a.profdata -ispre-workloads -ispre-workload-profile=%t.a.json:1 -ispre-workload-profile=%t.b.json:3 -ispre -pass-remarks=ispre -pass-remarks-missed=ispre %S/ispre_test1.ll -o /dev/null 2>&1 | FileCheck %s --check-prefix=VETO
+; RUN: opt -enable-new-pm=0 -load %ispre -pgo-instr-use -pgo-test-profile-file=%t.a.profdata -ispre-workloads -ispre-workload-profile=%t.a.json:3 -ispre-workload-profile=%t.b.json:1 -ispre -pass-remarks=ispre -pass-remarks-missed=ispre %S/ispre_test1.ll -o /dev/null 2>&1 | FileCheck %s --check-prefix=QUORUM
+;
+; VETO-NOT: speculated %mul
+; VETO: not speculated %mul = mul nsw i64 %3, %4: use site if.else is cold (count 9988245)
+; VETO-NOT: speculated %mul
+;
+; QUORUM: speculated %mul = mul nsw i64 %3, %4 on ingress edge entry -> for.cond (edge count 1, source count 1)
+; QUORUM-NEXT: replaced %mul = mul nsw i64 %3, %4 in if.else
@@ -0,0 +1,59 @@
+#!/bin/bash
+
+# help output for program
+help()
+{
+    # Display Help
+    echo "Helper script to run get_statistics.sh on the kernels in kernels/ and check their checksums."
+    echo
+    echo "Syntax: run_kernels [-h] [-p pass_string] [kernel...]"
+    echo "options:"
+    echo "   - h     Print this help."
+    echo "   - p     Pass string handed to get_statistics.sh (defaults to \"-ispre\")"
+    echo "argument:"
+    echo "   - kernel    Kernel names without the .c extension, i.e. \"hash_fnv\""
+    echo "               ** Defaults to every kernel listed in kernels/CHECKSUMS"
+}
+
+passes="-ispre"
+# Get command line options
+while getopts ":hp:" option; do
+    case $option in
+        h) # display help
+            help
+            exit;;
+        p) # pass string
+            passes=${OPTARG};;
+        \?) # incorrect option
+            echo "Error: Invalid option"
+            exit 1;;
+    esac
+done
+# Shift cli arguments to ignore options
+shift "$((OPTIND-1))"
+
+kernels=${@:-$(cut -d' ' -f1 kernels/CHECKSUMS)}
+failures=0
+
+for kernel in ${kernels}; do
+    expected=$(grep "^${kernel} " kernels/CHECKSUMS | cut -d' ' -f2)
+    echo "##### ${kernel} #####"
+    ./get_statistics.sh kernels/${kernel} "${passes}" | tee ${kernel}.log
+    actual=$(sed 's/Checksum: //' correct_output 2>/dev/null)
+    rm -f default.profraw *_output kernels/${kernel}.profdata kernels/${kernel}.*bc
+    rm -f kernels/${kernel}_{prof,no_ispre,gvn,ispre,multiispre}
+
+    # The profiled build must reproduce the checksum of the fixed input, and every optimized
+    # build must pass get_statistics.sh's correctness check
+    if [ "${actual}" != "${expected}" ]; then
+        echo ">> ${kernel}: checksum ${actual}, expected ${expected}"
+        failures=$((failures + 1))
+    elif grep -q "FAIL" ${kernel}.log; then
+        echo ">> ${kernel}: optimized build produced different output"
+        failures=$((failures + 1))
+    fi
+    rm -f ${kernel}.log
+done
+
+echo "${failures} kernel(s) failed"
+[ "${failures}" -eq 0 ]
@@ -0,0 +1,68 @@
+#!/bin/bash
+
+# help output for program
+help()
+{
+    # Display Help
+    echo "Helper script to run the regression checks in regress/."
+    echo
+    echo "Syntax: run_regress [-h] [-b build_dir] [test...]"
+    echo "options:"
+    echo "   - h     Print this help."
+    echo "   - b     Build directory holding ISPRE/ISPRE.so and the tools (defaults to \"../build\")"
+    echo "argument:"
+    echo "   - test      Test names without the .ll extension, i.e. \"ispre_test1\""
+    echo "               ** Defaults to every .ll file in regress/"
+    echo
+    echo "Every \"; RUN:\" line of a test is run with bash from this directory, after replacing"
+    echo "%s with the test file, %S with regress/, %t with a temporary file prefix, %ispre with the"
+    echo "pass plugin and %build with the build directory. A test fails if any line fails;"
+    echo "FileCheck (from llvm-config --bindir) checks the output against the test's comments."
+}
+
+build_dir="../build"
+# Get command line options
+while getopts ":hb:" option; do
+    case $option in
+        h) # display help
+            help
+            exit;;
+        b) # build directory
+            build_dir=${OPTARG};;
+        \?) # incorrect option
+            echo "Error: Invalid option"
+            exit 1;;
+    esac
+done
+# Shift cli arguments to ignore options
+shift "$((OPTIND-1))"
+
+export PATH="${PATH}:$(llvm-config --bindir)"
+tests=${@:-$(basename -s .ll regress/*.ll)}
+temp_dir=$(mktemp -d)
+failures=0
+
+for test in ${tests}; do
+    file=regress/${test}.ll
+    failed=0
+    while read -r command; do
+        command=${command//%ispre/${build_dir}/ISPRE/ISPRE.so}
+        command=${command//%build/${build_dir}}
+        command=${command//%s/${file}}
+        command=${command//%S/regress}
+        command=${command//%t/${temp_dir}/${test}}
+        if ! bash -o pipefail -c "${command}"; then
+            echo ">> ${test}: failed: ${command}"
+            failed=1
+            break
+        fi
+    done < <(sed -n 's/^; RUN: //p' ${file})
+    if [ "${failed}" -eq 0 ]; then
+        echo "${test}: ok"
+    fi
+    failures=$((failures + failed))
+done
+
+rm -rf ${temp_dir}
+echo "${failures} test(s) failed"
+[ "${failures}" -eq 0 ]
@@ -1,12 +1,16 @@
 #!/bin/bash
-# Usage: viz.sh hw2correctN or vis.sh hw2correctN.fplicm [TYPE]
-# TYPE should be one of: cfg, cfg-only, dom, dom-only, postdom, postdom-only.
+# Usage: viz.sh hw2correctN or vis.sh hw2correctN.fplicm [TYPE] [PASSES]
+# TYPE should be one of: cfg, cfg-only, dom, dom-only, postdom, postdom-only, ispre.
 # Default type is cfg.
+# The ispre type runs PASSES (default "-ispre") with the profile and draws each function's CFG
+# colored by block temperature, with ingress edges and inserted/removed expressions marked.
 
 BENCH=$1
 
 # Default to cfg
 VIZ_TYPE=${2:-cfg}
+PASSES=${3:-"-ispre"}
+LLVM_LIBRARY=$(realpath ../build/ISPRE/ISPRE.so)
 
 OUTPUT_DIR=$(realpath ./dot)  # will put .pdf file here
 TMP_DIR=$OUTPUT_DIR/tmp       # will put .dot files here
@@ -37,7 +41,17 @@ BITCODE=$BITCODE_DIR/$BENCH.bc
 # fi
 
 # Generate .dot files in tmp dir
-opt $PROF_FLAGS -enable-new-pm=0 -dot-$VIZ_TYPE $BITCODE > /dev/null
+if [[ $VIZ_TYPE == "ispre" ]]; then
+  PROF_DATA=$BITCODE_DIR/$BENCH.profdata
+  if [[ ! -f $PROF_DATA ]]; then
+    echo "No prof data, cannot classify hot and cold blocks"
+    exit 1
+  fi
+  opt -enable-new-pm=0 -pgo-instr-use -pgo-test-profile-file=$PROF_DATA -load $LLVM_LIBRARY \
+    $PASSES -ispre-dump-dot=$TMP_DIR $BITCODE > /dev/null
+else
+  opt $PROF_FLAGS -enable-new-pm=0 -dot-$VIZ_TYPE $BITCODE > /dev/null
+fi
 
 # Combine .dot files into PDF
 if [[ $VIZ_TYPE == "cfg" ]]; then
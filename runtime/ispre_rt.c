@@ -0,0 +1,97 @@
+/*===----------------------------------------------------------------------===*
+ *
+ *  ISPRE runtime: dumps the counters added by -ispre-instrument and -ispre-path-profile-gen
+ *
+ *  Every instrumented expression owns one struct ispre_counter, placed by the pass in the
+ *  ispre_counters section. At exit the counts are written to $ISPRE_COUNTS_FILE, or to
+ *  ispre.counts in the working directory, as tab separated lines. Every path profiled
+ *  function likewise owns one struct ispre_path_table in the ispre_paths section, and the
+ *  counts of its paths are written to $ISPRE_PATHS_FILE, or to ispre.paths.
+ *
+ *===----------------------------------------------------------------------===*/
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Must match the layout created by createCounter in the passes */
+struct ispre_counter {
+    uint64_t saved; /* executions of the replaced expression */
+    uint64_t added; /* executions of the speculated insertions */
+    const char *function;
+    const char *site; /* pass:block:index, stable across builds */
+    const char *expression;
+};
+
+/* Referenced by every instrumented module so that linking libispre_rt.a pulls this file in */
+int __ispre_runtime;
+
+extern struct ispre_counter __start_ispre_counters[] __attribute__((weak));
+extern struct ispre_counter __stop_ispre_counters[] __attribute__((weak));
+
+__attribute__((destructor)) static void ispre_dump_counters(void) {
+    struct ispre_counter *counter;
+    const char *path = getenv("ISPRE_COUNTS_FILE");
+    FILE *out;
+    uint64_t saved = 0;
+    uint64_t added = 0;
+
+    if (__start_ispre_counters == __stop_ispre_counters) {
+        return;
+    }
+    out = fopen(path ? path : "ispre.counts", "w");
+    if (!out) {
+        perror("ispre_rt");
+        return;
+    }
+
+    fprintf(out, "function\tsite\texpression\tsaved\tadded\tnet\n");
+    for (counter = __start_ispre_counters; counter != __stop_ispre_counters; counter++) {
+        fprintf(out, "%s\t%s\t%s\t%" PRIu64 "\t%" PRIu64 "\t%" PRId64 "\n", counter->function,
+                counter->site, counter->expression, counter->saved, counter->added,
+                (int64_t)(counter->saved - counter->added));
+        saved += counter->saved;
+        added += counter->added;
+    }
+    fprintf(out, "total\t-\t-\t%" PRIu64 "\t%" PRIu64 "\t%" PRId64 "\n", saved, added,
+            (int64_t)(saved - added));
+    fclose(out);
+}
+
+/* Must match the layout created by createTable in -ispre-path-profile-gen */
+struct ispre_path_table {
+    const char *function;
+    uint64_t num_paths;
+    uint64_t *counts; /* one per Ball-Larus path number */
+};
+
+extern struct ispre_path_table __start_ispre_paths[] __attribute__((weak));
+extern struct ispre_path_table __stop_ispre_paths[] __attribute__((weak));
+
+__attribute__((destructor)) static void ispre_dump_paths(void) {
+    struct ispre_path_table *table;
+    const char *path = getenv("ISPRE_PATHS_FILE");
+    FILE *out;
+    uint64_t number;
+
+    if (__start_ispre_paths == __stop_ispre_paths) {
+        return;
+    }
+    out = fopen(path ? path : "ispre.paths", "w");
+    if (!out) {
+        perror("ispre_rt");
+        return;
+    }
+
+    /* Only the paths that ran; the number of paths identifies the CFG they were numbered on */
+    fprintf(out, "function\tpaths\tpath\tcount\n");
+    for (table = __start_ispre_paths; table != __stop_ispre_paths; table++) {
+        for (number = 0; number < table->num_paths; number++) {
+            if (table->counts[number]) {
+                fprintf(out, "%s\t%" PRIu64 "\t%" PRIu64 "\t%" PRIu64 "\n", table->function,
+                        table->num_paths, number, table->counts[number]);
+            }
+        }
+    }
+    fclose(out);
+}
@@ -0,0 +1,414 @@
+//===----------------------------------------------------------------------===//
+//
+//  ispre-autotune: search the hot/cold thresholds of ISPRE for one program
+//
+//  Compiles a profiled program with every threshold of a grid for a single ISPRE pass and
+//  with every decreasing cascade of thresholds for up to four passes, checks that every
+//  variant prints the same output as the program without ISPRE, and measures all of them
+//  with ispre-runbench. Reports the Pareto front of runtime against .text size and picks the
+//  fastest configuration that stays within a code growth budget.
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::opt<std::string> InputFile(cl::Positional, cl::Required,
+                                      cl::desc("<unoptimized program .bc>"));
+
+static cl::opt<std::string> ProfileFile("profdata", cl::desc("Profile of the program"),
+                                        cl::value_desc("file"), cl::Required);
+
+static cl::opt<std::string> ProgramArgs("args", cl::desc("Arguments of every measured run"),
+                                        cl::init(""));
+
+static cl::opt<std::string> Libraries("libs", cl::desc("Extra arguments of the link"),
+                                      cl::init(""));
+
+static cl::list<double> Grid("grid", cl::CommaSeparated,
+                             cl::desc("Thresholds of a single pass (default "
+                                      "0.95,0.9,0.8,0.7,0.6,0.45,0.3,0.22,0.11,0.05)"));
+
+static cl::list<double> CascadeGrid("cascade-grid", cl::CommaSeparated,
+                                    cl::desc("Thresholds combined into cascades of passes "
+                                             "(default 0.9,0.6,0.3,0.11)"));
+
+static cl::opt<unsigned> MaxStages("max-stages", cl::desc("Longest cascade of passes (1 to 4)"),
+                                   cl::init(4));
+
+static cl::opt<std::string> Metric("metric",
+                                   cl::desc("ispre-runbench metric to minimize (seconds, cycles, "
+                                            "instructions, ...)"),
+                                   cl::init("seconds"));
+
+static cl::opt<double> MaxGrowth("max-growth",
+                                 cl::desc("Largest .text growth over the program without ISPRE "
+                                          "allowed for the chosen configuration"),
+                                 cl::init(0.05));
+
+static cl::opt<unsigned> Runs("runs", cl::desc("Measured runs of every variant"), cl::init(9));
+
+static cl::opt<unsigned> Warmup("warmup", cl::desc("Unmeasured runs of every variant"),
+                                cl::init(1));
+
+static cl::opt<unsigned> Timeout("timeout",
+                               cl::desc("Seconds a variant may run when its output is checked"),
+                               cl::init(60));
+
+static cl::opt<std::string> WorkDir("work", cl::desc("Directory for the variants"),
+                                    cl::init("autotune"));
+
+static cl::opt<std::string> PluginPath("plugin", cl::desc("ISPRE plugin (default: from the build)"),
+                                       cl::init(""));
+
+static cl::opt<std::string> RunbenchPath("runbench",
+                                         cl::desc("ispre-runbench (default: from the build)"),
+                                         cl::init(""));
+
+static cl::opt<std::string> OutputFile("o", cl::desc("JSON report of every variant"),
+                                       cl::value_desc("file"), cl::init(""));
+
+namespace {
+// The registered names of the passes, in the order a cascade runs them
+const char *PassNames[] = {"ispre", "ispre2", "ispre3", "ispre4"};
+
+// The cascade get_statistics.sh uses for its multipass build
+const double DefaultCascade[] = {0.9, 0.45, 0.22, 0.11};
+
+struct Variant {
+    std::string name;
+    std::vector<double> thresholds;
+    std::string binary;
+    bool correct = false;
+    double cost = -1;
+    int64_t textSize = -1;
+    bool pareto = false;
+};
+
+std::string getName(const std::vector<double> &thresholds) {
+    if (thresholds.empty()) {
+        return "none";
+    }
+    std::string name;
+    for (double threshold : thresholds) {
+        name += (name.empty() ? "t" : "-") + formatv("{0:F2}", threshold).str();
+    }
+    return name;
+}
+
+// The opt arguments that run one pass per threshold
+std::vector<std::string> getPassArgs(const std::vector<double> &thresholds) {
+    std::vector<std::string> args;
+    for (size_t stage = 0; stage < thresholds.size(); stage++) {
+        args.push_back(std::string("-") + PassNames[stage]);
+        args.push_back(formatv("-{0}-threshold={1}", PassNames[stage], thresholds[stage]).str());
+    }
+    return args;
+}
+
+// Every decreasing sequence of `length` values of `grid`, which is sorted in decreasing order
+void addCascades(const std::vector<double> &grid, size_t length, size_t from,
+                 std::vector<double> &prefix, std::vector<std::vector<double>> &into) {
+    if (prefix.size() == length) {
+        into.push_back(prefix);
+        return;
+    }
+    for (size_t i = from; i < grid.size(); i++) {
+        prefix.push_back(grid[i]);
+        addCascades(grid, length, i + 1, prefix, into);
+        prefix.pop_back();
+    }
+}
+
+std::vector<Variant> getVariants() {
+    std::vector<double> single(Grid.begin(), Grid.end());
+    if (single.empty()) {
+        single = {0.95, 0.9, 0.8, 0.7, 0.6, 0.45, 0.3, 0.22, 0.11, 0.05};
+    }
+    std::vector<double> cascade(CascadeGrid.begin(), CascadeGrid.end());
+    if (cascade.empty()) {
+        cascade = {0.9, 0.6, 0.3, 0.11};
+    }
+    std::sort(cascade.rbegin(), cascade.rend());
+    cascade.erase(std::unique(cascade.begin(), cascade.end()), cascade.end());
+
+    std::vector<std::vector<double>> configurations = {{}};
+    for (double threshold : single) {
+        configurations.push_back({threshold});
+    }
+    std::vector<double> prefix;
+    for (size_t length = 2; length <= std::min(MaxStages.getValue(), 4u); length++) {
+        addCascades(cascade, length, 0, prefix, configurations);
+    }
+    if (MaxStages >= 4) {
+        configurations.push_back(std::vector<double>(std::begin(DefaultCascade),
+                                                     std::end(DefaultCascade)));
+    }
+
+    std::vector<Variant> variants;
+    for (const std::vector<double> &thresholds : configurations) {
+        std::string name = getName(thresholds);
+        if (std::none_of(variants.begin(), variants.end(),
+                         [&](const Variant &v) { return v.name == name; })) {
+            variants.push_back({name, thresholds});
+        }
+    }
+    return variants;
+}
+
+// Run a program found on PATH (or given by path) and wait for it, killing it after
+// `seconds` if that is not 0
+bool run(StringRef program, const std::vector<std::string> &args, StringRef stdoutFile = "",
+         unsigned seconds = 0) {
+    ErrorOr<std::string> path = program.contains('/') ? ErrorOr<std::string>(program.str())
+                                                      : sys::findProgramByName(program);
+    if (!path) {
+        WithColor::error() << program << ": not found\n";
+        return false;
+    }
+    std::vector<StringRef> argv = {*path};
+    argv.insert(argv.end(), args.begin(), args.end());
+    Optional<StringRef> redirects[] = {None, None, None};
+    if (!stdoutFile.empty()) {
+        redirects[1] = stdoutFile;
+    }
+    std::string message;
+    int status = sys::ExecuteAndWait(*path, argv, None, redirects, seconds, 0, &message);
+    if (status != 0) {
+        WithColor::error() << program << ": " << (message.empty() ? "failed" : message) << "\n";
+        return false;
+    }
+    return true;
+}
+
+std::vector<std::string> splitWords(StringRef text) {
+    SmallVector<StringRef, 8> words;
+    text.split(words, ' ', -1, false);
+    return std::vector<std::string>(words.begin(), words.end());
+}
+
+bool build(Variant &variant, StringRef plugin) {
+    std::string prefix = WorkDir + "/" + variant.name;
+    std::vector<std::string> optArgs = {"-enable-new-pm=0", "-pgo-instr-use",
+                                        "-pgo-test-profile-file=" + ProfileFile};
+    if (!variant.thresholds.empty()) {
+        optArgs.push_back("-load");
+        optArgs.push_back(plugin.str());
+        std::vector<std::string> passes = getPassArgs(variant.thresholds);
+        optArgs.insert(optArgs.end(), passes.begin(), passes.end());
+    }
+    optArgs.insert(optArgs.end(), {"-dce", InputFile, "-o", prefix + ".bc"});
+    if (!run("opt", optArgs)) {
+        return false;
+    }
+    std::vector<std::string> linkArgs = {prefix + ".bc"};
+    for (std::string &word : splitWords(Libraries)) {
+        linkArgs.push_back(word);
+    }
+    linkArgs.insert(linkArgs.end(), {"-o", prefix});
+    variant.binary = prefix;
+    return run("clang", linkArgs);
+}
+
+Optional<std::string> readFile(StringRef path) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(path);
+    if (!buffer) {
+        return None;
+    }
+    return (*buffer)->getBuffer().str();
+}
+
+// Mark the variants not dominated in cost and size by another correct variant
+void markPareto(std::vector<Variant> &variants) {
+    for (Variant &variant : variants) {
+        if (!variant.correct || variant.cost < 0) {
+            continue;
+        }
+        variant.pareto = std::none_of(variants.begin(), variants.end(), [&](const Variant &other) {
+            return other.correct && other.cost >= 0 && other.cost <= variant.cost &&
+                   other.textSize <= variant.textSize &&
+                   (other.cost < variant.cost || other.textSize < variant.textSize);
+        });
+    }
+}
+
+// Path of a file of the build tree next to this tool's directory
+std::string getBuildPath(const char *argv0, StringRef relative) {
+    std::string self = sys::fs::getMainExecutable(argv0, (void *)&getBuildPath);
+    SmallString<256> path(sys::path::parent_path(sys::path::parent_path(
+        sys::path::parent_path(self))));
+    sys::path::append(path, relative);
+    return std::string(path.str());
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "ISPRE threshold autotuner\n");
+
+    std::string plugin = PluginPath.empty() ? getBuildPath(argv[0], "ISPRE/ISPRE.so") : PluginPath;
+    std::string runbench = RunbenchPath.empty()
+                               ? getBuildPath(argv[0], "tools/ispre-runbench/ispre-runbench")
+                               : RunbenchPath;
+    if (std::error_code EC = sys::fs::create_directories(WorkDir)) {
+        WithColor::error() << WorkDir << ": " << EC.message() << "\n";
+        return 1;
+    }
+
+    std::vector<Variant> variants = getVariants();
+    errs() << "Building " << variants.size() << " variants in " << WorkDir << "\n";
+    for (Variant &variant : variants) {
+        if (!build(variant, plugin)) {
+            return 1;
+        }
+    }
+
+    // Every variant must print what the program without ISPRE prints
+    std::vector<std::string> args = splitWords(ProgramArgs);
+    Optional<std::string> expected;
+    for (Variant &variant : variants) {
+        std::string output = variant.binary + ".out";
+        // A wrong speculation can turn a loop into an endless one
+        if (!run(variant.binary, args, output, Timeout)) {
+            WithColor::warning() << variant.name << ": failed, not measured\n";
+            continue;
+        }
+        Optional<std::string> printed = readFile(output);
+        if (!expected) {
+            expected = printed;
+        }
+        variant.correct = printed && *printed == *expected;
+        if (!variant.correct) {
+            WithColor::warning() << variant.name << ": output differs, not measured\n";
+        }
+    }
+    if (!variants.front().correct) {
+        WithColor::error() << "the program without ISPRE did not run\n";
+        return 1;
+    }
+
+    std::vector<std::string> benchArgs = {"-runs", std::to_string(Runs), "-warmup",
+                                          std::to_string(Warmup), "-o",
+                                          WorkDir + "/bench.json"};
+    for (const Variant &variant : variants) {
+        if (variant.correct) {
+            benchArgs.push_back(variant.name + "=" + variant.binary + " " + ProgramArgs);
+        }
+    }
+    if (!run(runbench, benchArgs, "/dev/null")) {
+        return 1;
+    }
+    Optional<std::string> benchText = readFile(WorkDir + "/bench.json");
+    Expected<json::Value> bench = json::parse(benchText ? *benchText : "");
+    const json::Object *benchRoot = bench ? bench->getAsObject() : nullptr;
+    const json::Array *binaries = benchRoot ? benchRoot->getArray("binaries") : nullptr;
+    if (!binaries) {
+        if (!bench) {
+            consumeError(bench.takeError());
+        }
+        WithColor::error() << WorkDir << "/bench.json: not an ispre-runbench result\n";
+        return 1;
+    }
+    for (const json::Value &entry : *binaries) {
+        const json::Object *binary = entry.getAsObject();
+        StringRef name = binary ? binary->getString("name").getValueOr("") : "";
+        auto variant = std::find_if(variants.begin(), variants.end(),
+                                    [&](const Variant &v) { return v.name == name; });
+        if (variant == variants.end()) {
+            continue;
+        }
+        const json::Object *metrics = binary->getObject("metrics");
+        const json::Object *metric = metrics ? metrics->getObject(Metric) : nullptr;
+        if (!metric) {
+            WithColor::error() << "metric " << Metric << " was not measured\n";
+            return 1;
+        }
+        variant->cost = metric->getNumber("median").getValueOr(-1);
+        variant->textSize = binary->getInteger("text_size").getValueOr(-1);
+    }
+    markPareto(variants);
+
+    // The fastest variant on the front within the growth budget; the program without ISPRE
+    // is always on the front or dominated by a variant that is
+    const Variant &none = variants.front();
+    const Variant *chosen = nullptr;
+    for (const Variant &variant : variants) {
+        if (variant.pareto && variant.textSize <= none.textSize * (1 + MaxGrowth) &&
+            (!chosen || variant.cost < chosen->cost)) {
+            chosen = &variant;
+        }
+    }
+
+    outs() << "Variant                       .text     Growth    Median " << Metric
+           << "   Speedup  Pareto\n";
+    for (const Variant &variant : variants) {
+        if (!variant.correct || variant.cost < 0) {
+            continue;
+        }
+        outs() << format("%-24s %10lld %+9.2f%% %16.6g %8.3fx  %s\n", variant.name.c_str(),
+                         (long long)variant.textSize,
+                         100.0 * (variant.textSize - none.textSize) / none.textSize,
+                         variant.cost, none.cost / variant.cost,
+                         &variant == chosen ? "chosen" : variant.pareto ? "*" : "");
+    }
+
+    json::Array results;
+    for (const Variant &variant : variants) {
+        json::Array passArgs;
+        for (std::string &arg : getPassArgs(variant.thresholds)) {
+            passArgs.push_back(arg);
+        }
+        results.push_back(json::Object{{"name", variant.name},
+                                       {"thresholds", json::Array(variant.thresholds)},
+                                       {"passes", std::move(passArgs)},
+                                       {"correct", variant.correct},
+                                       {"median", variant.cost >= 0 ? json::Value(variant.cost)
+                                                                    : nullptr},
+                                       {"text_size", variant.textSize >= 0
+                                                         ? json::Value(variant.textSize)
+                                                         : nullptr},
+                                       {"pareto", variant.pareto}});
+    }
+    json::Value report = json::Object{{"program", InputFile.getValue()},
+                                      {"metric", Metric.getValue()},
+                                      {"max_growth", MaxGrowth.getValue()},
+                                      {"chosen", chosen ? json::Value(chosen->name) : nullptr},
+                                      {"variants", std::move(results)}};
+    if (!OutputFile.empty()) {
+        std::error_code EC;
+        ToolOutputFile out(OutputFile, EC, sys::fs::OF_Text);
+        if (EC) {
+            WithColor::error() << OutputFile << ": " << EC.message() << "\n";
+            return 1;
+        }
+        out.os() << formatv("{0:2}", report) << "\n";
+        out.keep();
+    }
+
+    if (chosen) {
+        outs() << "\nChosen: " << chosen->name << "\n  opt";
+        for (std::string &arg : getPassArgs(chosen->thresholds)) {
+            outs() << " " << arg;
+        }
+        outs() << "\n";
+    }
+    return 0;
+}
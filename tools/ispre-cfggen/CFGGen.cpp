@@ -0,0 +1,323 @@
+//===----------------------------------------------------------------------===//
+//
+//  Synthetic CFG generator for ISPRE compile-time experiments
+//
+//  Every shape is a single function whose blocks compute the same few expressions over
+//  loads of shared variables, so the pass has candidates everywhere. Each expression is one
+//  binary operator over two loads: the pass clones the operands of an expression it
+//  speculates one level deep, so an expression over another one would leave invalid IR. Entry counts and
+//  branch weights stand in for a profile run; hot paths get weights of 99:1 or more.
+//
+////===----------------------------------------------------------------------===//
+#include "CFGGen.h"
+
+#include "llvm/ADT/Twine.h"
+#include "llvm/IR/BasicBlock.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/IRBuilder.h"
+#include "llvm/IR/MDBuilder.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <vector>
+
+using namespace llvm;
+
+const Shape AllShapes[5] = {Shape::LoopNest, Shape::Switch, Shape::Diamonds,
+                            Shape::Irreducible, Shape::AliasedStores};
+
+StringRef getShapeName(Shape shape) {
+    switch (shape) {
+    case Shape::LoopNest:
+        return "loopnest";
+    case Shape::Switch:
+        return "switch";
+    case Shape::Diamonds:
+        return "diamonds";
+    case Shape::Irreducible:
+        return "irreducible";
+    case Shape::AliasedStores:
+        return "stores";
+    }
+    llvm_unreachable("unknown shape");
+}
+
+bool parseShape(StringRef name, Shape &shape) {
+    for (Shape candidate : AllShapes) {
+        if (getShapeName(candidate) == name) {
+            shape = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+namespace {
+// Number of variables the expressions of every shape are computed over
+constexpr unsigned NumVars = 4;
+
+struct Generator {
+    LLVMContext &ctx;
+    Function *F;
+    IRBuilder<> IRB;
+    MDBuilder MDB;
+    Type *i32Ty;
+    Value *n;
+    Value *sum;
+    std::vector<Value *> vars;
+    // Expressions computed by every block of the shapes other than the loop nest
+    unsigned exprsPerBlock;
+
+    Generator(LLVMContext &ctx, Module &M, StringRef name, unsigned exprsPerBlock)
+        : ctx(ctx), IRB(ctx), MDB(ctx), i32Ty(IRB.getInt32Ty()), exprsPerBlock(exprsPerBlock) {
+        FunctionType *fnTy = FunctionType::get(i32Ty, {i32Ty}, false);
+        F = Function::Create(fnTy, GlobalValue::ExternalLinkage, name, M);
+        F->setEntryCount(1);
+        n = F->getArg(0);
+
+        IRB.SetInsertPoint(block("entry"));
+        for (unsigned i = 0; i < NumVars; i++) {
+            vars.push_back(IRB.CreateAlloca(i32Ty, nullptr, "v" + Twine(i)));
+            IRB.CreateStore(IRB.getInt32(i + 1), vars.back());
+        }
+        sum = IRB.CreateAlloca(i32Ty, nullptr, "sum");
+        IRB.CreateStore(IRB.getInt32(0), sum);
+    }
+
+    BasicBlock *block(const Twine &name) { return BasicBlock::Create(ctx, name, F); }
+
+    Value *load(Value *ptr) { return IRB.CreateLoad(i32Ty, ptr); }
+
+    // Store `count` expressions over the shared variables to sum, starting at `seed`
+    void exprs(unsigned count, unsigned seed) {
+        Instruction::BinaryOps ops[] = {Instruction::Add, Instruction::Mul, Instruction::Xor,
+                                        Instruction::Sub};
+        for (unsigned e = 0; e < count; e++) {
+            unsigned k = seed + e;
+            Value *expr =
+                IRB.CreateBinOp(ops[k % 4], load(vars[k % NumVars]), load(vars[(k + 1) % NumVars]));
+            IRB.CreateStore(expr, sum);
+        }
+    }
+
+    void increment(Value *var) { IRB.CreateStore(IRB.CreateAdd(load(var), IRB.getInt32(1)), var); }
+
+    void condBr(Value *cond, BasicBlock *taken, BasicBlock *other, uint32_t takenWeight,
+                uint32_t otherWeight) {
+        IRB.CreateCondBr(cond, taken, other, MDB.createBranchWeights(takenWeight, otherWeight));
+    }
+
+    void ret() { IRB.CreateRet(load(sum)); }
+};
+
+// A perfect nest of `depth` counted loops; every level does a little work before entering the
+// next one and the innermost body does the most. Each level runs twice per outer iteration, so
+// the innermost body is 2^depth times hotter than the entry without overflowing the counts.
+void buildLoopNest(Generator &G, unsigned depth) {
+    std::vector<Value *> ivs;
+    for (unsigned d = 0; d < depth; d++) {
+        ivs.push_back(G.IRB.CreateAlloca(G.i32Ty, nullptr, "i" + Twine(d)));
+    }
+    BasicBlock *exit = G.block("exit");
+    BasicBlock *outerLatch = exit;
+
+    for (unsigned d = 0; d < depth; d++) {
+        BasicBlock *header = G.block("header" + Twine(d));
+        BasicBlock *body = G.block("body" + Twine(d));
+        BasicBlock *latch = G.block("latch" + Twine(d));
+
+        G.IRB.CreateStore(G.IRB.getInt32(0), ivs[d]);
+        G.exprs(1, d);
+        G.IRB.CreateBr(header);
+
+        G.IRB.SetInsertPoint(header);
+        Value *cond = G.IRB.CreateICmpSLT(G.load(ivs[d]), G.IRB.getInt32(2));
+        G.condBr(cond, body, outerLatch, 2, 1);
+
+        G.IRB.SetInsertPoint(latch);
+        G.increment(ivs[d]);
+        G.IRB.CreateBr(header);
+
+        G.IRB.SetInsertPoint(body);
+        outerLatch = latch;
+    }
+    G.exprs(NumVars, 0);
+    G.IRB.CreateBr(outerLatch);
+
+    G.IRB.SetInsertPoint(exit);
+    G.ret();
+}
+
+// A hot loop around one switch with `cases` cases; case 0 takes almost all iterations and a
+// few cold cases clobber the operands of the expressions every case computes
+void buildSwitch(Generator &G, unsigned cases) {
+    Value *iv = G.IRB.CreateAlloca(G.i32Ty, nullptr, "i");
+    G.IRB.CreateStore(G.IRB.getInt32(0), iv);
+    BasicBlock *header = G.block("header");
+    BasicBlock *dispatch = G.block("dispatch");
+    BasicBlock *latch = G.block("latch");
+    BasicBlock *exit = G.block("exit");
+    G.IRB.CreateBr(header);
+
+    G.IRB.SetInsertPoint(header);
+    G.condBr(G.IRB.CreateICmpSLT(G.load(iv), G.n), dispatch, exit, 100000, 1);
+
+    G.IRB.SetInsertPoint(dispatch);
+    Value *selector = G.IRB.CreateSRem(G.load(iv), G.IRB.getInt32(cases + 1));
+    SwitchInst *sw = G.IRB.CreateSwitch(selector, latch, cases);
+    std::vector<uint32_t> weights = {1};
+    for (unsigned c = 0; c < cases; c++) {
+        BasicBlock *arm = G.block("case" + Twine(c));
+        sw->addCase(G.IRB.getInt32(c), arm);
+        weights.push_back(c == 0 ? 100000 : 1);
+
+        G.IRB.SetInsertPoint(arm);
+        G.exprs(G.exprsPerBlock, c);
+        if (c % 8 == 7) {
+            G.IRB.CreateStore(G.load(iv), G.vars[c % NumVars]);
+        }
+        G.IRB.CreateBr(latch);
+    }
+    sw->setMetadata(LLVMContext::MD_prof, G.MDB.createBranchWeights(weights));
+
+    G.IRB.SetInsertPoint(latch);
+    G.increment(iv);
+    G.IRB.CreateBr(header);
+
+    G.IRB.SetInsertPoint(exit);
+    G.ret();
+}
+
+// A hot loop whose body is a ladder of `diamonds` diamonds; the cold arm of every diamond
+// clobbers one operand of the expressions both arms compute
+void buildDiamonds(Generator &G, unsigned diamonds) {
+    Value *iv = G.IRB.CreateAlloca(G.i32Ty, nullptr, "i");
+    G.IRB.CreateStore(G.IRB.getInt32(0), iv);
+    BasicBlock *header = G.block("header");
+    BasicBlock *exit = G.block("exit");
+    G.IRB.CreateBr(header);
+
+    BasicBlock *next = G.block("cond0");
+    G.IRB.SetInsertPoint(header);
+    G.condBr(G.IRB.CreateICmpSLT(G.load(iv), G.n), next, exit, 100000, 1);
+
+    for (unsigned d = 0; d < diamonds; d++) {
+        BasicBlock *cond = next;
+        BasicBlock *hot = G.block("hot" + Twine(d));
+        BasicBlock *cold = G.block("cold" + Twine(d));
+        next = G.block(d + 1 == diamonds ? "latch" : "cond" + Twine(d + 1));
+
+        G.IRB.SetInsertPoint(cond);
+        Value *rem = G.IRB.CreateSRem(G.load(iv), G.IRB.getInt32(100 + d));
+        G.condBr(G.IRB.CreateICmpNE(rem, G.IRB.getInt32(0)), hot, cold, 99, 1);
+
+        for (BasicBlock *arm : {hot, cold}) {
+            G.IRB.SetInsertPoint(arm);
+            G.exprs(G.exprsPerBlock, d);
+            if (arm == cold) {
+                G.IRB.CreateStore(G.load(iv), G.vars[d % NumVars]);
+            }
+            G.IRB.CreateBr(next);
+        }
+    }
+
+    G.IRB.SetInsertPoint(next);
+    G.increment(iv);
+    G.IRB.CreateBr(header);
+
+    G.IRB.SetInsertPoint(exit);
+    G.ret();
+}
+
+// A cycle of `size` blocks entered both at its first block and half way round, so no block
+// dominates the others. Every block leaves the cycle with a small probability.
+void buildIrreducible(Generator &G, unsigned size) {
+    Value *iv = G.IRB.CreateAlloca(G.i32Ty, nullptr, "i");
+    G.IRB.CreateStore(G.IRB.getInt32(0), iv);
+    std::vector<BasicBlock *> cycle;
+    for (unsigned b = 0; b < size; b++) {
+        cycle.push_back(G.block("r" + Twine(b)));
+    }
+    BasicBlock *exit = G.block("exit");
+    G.condBr(G.IRB.CreateICmpSGT(G.n, G.IRB.getInt32(0)), cycle[0], cycle[size / 2], 1, 1);
+
+    for (unsigned b = 0; b < size; b++) {
+        G.IRB.SetInsertPoint(cycle[b]);
+        G.exprs(G.exprsPerBlock, b);
+        G.increment(iv);
+        if (b % 8 == 7) {
+            G.IRB.CreateStore(G.load(iv), G.vars[b % NumVars]);
+        }
+        Value *cond = G.IRB.CreateICmpSLT(G.load(iv), G.n);
+        G.condBr(cond, cycle[(b + 1) % size], exit, 1000, 1);
+    }
+
+    G.IRB.SetInsertPoint(exit);
+    G.ret();
+}
+
+// A hot loop whose body stores `stores` times to a handful of pointers that all alias the
+// operands of the expressions, 16 stores to a block
+void buildAliasedStores(Generator &G, unsigned stores) {
+    Value *iv = G.IRB.CreateAlloca(G.i32Ty, nullptr, "i");
+    G.IRB.CreateStore(G.IRB.getInt32(0), iv);
+    BasicBlock *header = G.block("header");
+    BasicBlock *exit = G.block("exit");
+    G.IRB.CreateBr(header);
+
+    BasicBlock *next = G.block("body0");
+    G.IRB.SetInsertPoint(header);
+    G.condBr(G.IRB.CreateICmpSLT(G.load(iv), G.n), next, exit, 100000, 1);
+
+    unsigned blocks = (stores + 15) / 16;
+    for (unsigned b = 0; b < blocks; b++) {
+        G.IRB.SetInsertPoint(next);
+        next = G.block(b + 1 == blocks ? "latch" : "body" + Twine(b + 1));
+        G.exprs(G.exprsPerBlock, b);
+        for (unsigned s = b * 16; s < std::min(stores, (b + 1) * 16); s++) {
+            G.IRB.CreateStore(G.IRB.CreateAdd(G.load(iv), G.IRB.getInt32(s)),
+                              G.vars[s % NumVars]);
+        }
+        G.exprs(G.exprsPerBlock, b + 1);
+        G.IRB.CreateBr(next);
+    }
+
+    G.IRB.SetInsertPoint(next);
+    G.increment(iv);
+    G.IRB.CreateBr(header);
+
+    G.IRB.SetInsertPoint(exit);
+    G.ret();
+}
+} // namespace
+
+std::unique_ptr<Module> generateCFG(LLVMContext &ctx, Shape shape, unsigned size,
+                                    unsigned exprs) {
+    std::string name = (getShapeName(shape) + "_" + Twine(size)).str();
+    auto M = std::make_unique<Module>(name, ctx);
+    Generator G(ctx, *M, name, exprs);
+
+    switch (shape) {
+    case Shape::LoopNest:
+        buildLoopNest(G, size);
+        break;
+    case Shape::Switch:
+        buildSwitch(G, size);
+        break;
+    case Shape::Diamonds:
+        buildDiamonds(G, size);
+        break;
+    case Shape::Irreducible:
+        buildIrreducible(G, std::max(size, 2u));
+        break;
+    case Shape::AliasedStores:
+        buildAliasedStores(G, size);
+        break;
+    }
+
+    if (verifyModule(*M, &errs())) {
+        report_fatal_error(Twine("ispre-cfggen: generated ") + name + " is invalid");
+    }
+    return M;
+}
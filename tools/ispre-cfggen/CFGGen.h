@@ -0,0 +1,34 @@
+//===----------------------------------------------------------------------===//
+//
+//  Synthetic CFG generator for ISPRE compile-time experiments
+//
+////===----------------------------------------------------------------------===//
+#ifndef ISPRE_CFGGEN_H
+#define ISPRE_CFGGEN_H
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+
+#include <memory>
+
+enum class Shape {
+    LoopNest,      // size = nesting depth
+    Switch,        // size = number of cases of one switch in a hot loop
+    Diamonds,      // size = number of diamonds in a ladder inside a hot loop
+    Irreducible,   // size = number of blocks in a cycle entered at two points
+    AliasedStores, // size = number of stores to a few aliasing pointers in a hot loop
+};
+
+extern const Shape AllShapes[5];
+
+llvm::StringRef getShapeName(Shape shape);
+bool parseShape(llvm::StringRef name, Shape &shape);
+
+// Build a module with one function, @<shape>_<size>, carrying function entry counts and
+// branch weights so that it can be optimized with ISPRE without a profile run. Every block of
+// the shapes other than the loop nest (every arm, for diamonds) computes `exprs` expressions.
+std::unique_ptr<llvm::Module> generateCFG(llvm::LLVMContext &ctx, Shape shape, unsigned size,
+                                          unsigned exprs = 2);
+
+#endif // ISPRE_CFGGEN_H
@@ -0,0 +1,61 @@
+//===----------------------------------------------------------------------===//
+//
+//  ispre-cfggen: write synthetic CFGs with profile metadata as LLVM IR
+//
+//  The output can be fed straight to opt, e.g.
+//      ispre-cfggen -shape=switch -size=256 | opt -enable-new-pm=0 -load ISPRE.so -ispre
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "CFGGen.h"
+
+using namespace llvm;
+
+static cl::opt<std::string>
+    ShapeName("shape", cl::desc("Shape to generate: loopnest, switch, diamonds, irreducible or "
+                                "stores"),
+              cl::init("diamonds"));
+
+static cl::opt<unsigned> Size("size", cl::desc("Size of the shape (depth, cases, diamonds, "
+                                               "blocks or stores)"),
+                              cl::init(16));
+
+static cl::opt<unsigned> Exprs("exprs",
+                              cl::desc("Expressions computed by every block (every arm of a "
+                                       "diamond); the loop nest has a fixed mix"),
+                              cl::init(2));
+
+static cl::opt<std::string> OutputFile("o", cl::desc("Output file"), cl::value_desc("file"),
+                                       cl::init("-"));
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "ISPRE synthetic CFG generator\n");
+
+    Shape shape;
+    if (!parseShape(ShapeName, shape)) {
+        WithColor::error() << "unknown shape '" << ShapeName << "'\n";
+        return 1;
+    }
+
+    std::error_code EC;
+    ToolOutputFile out(OutputFile, EC, sys::fs::OF_Text);
+    if (EC) {
+        WithColor::error() << OutputFile << ": " << EC.message() << "\n";
+        return 1;
+    }
+
+    LLVMContext ctx;
+    std::unique_ptr<Module> M = generateCFG(ctx, shape, Size, Exprs);
+    M->print(out.os(), nullptr);
+    out.keep();
+    return 0;
+}
@@ -0,0 +1,324 @@
+//===----------------------------------------------------------------------===//
+//
+//  ispre-scaling: compile-time scaling suite for the phases of the ISPRE pass
+//
+//  Generates every synthetic shape at doubling sizes, runs the ispre pass on each and fits
+//  the growth of every phase as time ~ instructions^k by least squares on a log-log scale.
+//  Each phase declares the complexity class it is allowed to have; the tool exits with an
+//  error when a fitted exponent exceeds the exponent of that class. Phases known to grow
+//  faster than intended carry an explicit, commented budget override. A shape on which the
+//  pass leaves invalid IR is an error as well; its timings say nothing.
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "CFGGen.h"
+#include "PhaseObserver.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string> ShapeNames("shape", cl::desc("Shapes to run (default: all)"),
+                                        cl::CommaSeparated);
+
+static cl::opt<unsigned> Steps("steps", cl::desc("Number of sizes, each double the previous"),
+                               cl::init(4));
+
+static cl::opt<unsigned> Repeat("repeat", cl::desc("Runs per size; the fastest one is kept"),
+                                cl::init(3));
+
+static cl::opt<double> MinTime("min-time",
+                               cl::desc("Phases faster than this at the largest size (in "
+                                        "seconds) are too noisy to be judged"),
+                               cl::init(0.002));
+
+static cl::list<std::string> Budgets("budget",
+                                     cl::desc("Override the class of a phase, as phase=class "
+                                              "with class one of linear, nlogn, quadratic, "
+                                              "cubic, quartic"),
+                                     cl::CommaSeparated);
+
+namespace {
+struct ComplexityClass {
+    const char *name;
+    // Largest fitted exponent accepted for the class: the exponent itself plus room for
+    // measurement noise, and for nlogn the log factor over the sizes that are run
+    double maxExponent;
+};
+
+const ComplexityClass Classes[] = {{"linear", 1.3},
+                                   {"nlogn", 1.5},
+                                   {"quadratic", 2.3},
+                                   {"cubic", 3.3},
+                                   {"quartic", 4.3}};
+
+// Intended complexity of every phase in instructions of the function, in the order
+// runOnFunction executes them. Blocks, edges and expressions all grow with the instructions.
+// Classification and the local sets take one walk over the function; the dataflow phases
+// keep one set of expressions per block and sweep the blocks a number of times bounded by
+// the loop nesting, so they are quadratic.
+std::vector<std::pair<std::string, std::string>> Phases = {
+    {"calculateHotColdNodes", "linear"},
+    {"calculateHotColdEdges", "linear"},
+    {"calculateIngressEdges", "linear"},
+    {"fillXUses", "linear"},
+    {"fillGens", "linear"},
+    {"fillKills", "nlogn"},
+    {"fillCandidates", "linear"},
+    {"fillAvinAvouts", "quadratic"},
+    {"fillRemovables", "quadratic"},
+    {"compute_needin_needout", "quadratic"},
+    {"compute_inserts", "quadratic"},
+    {"emitMissedRemarks", "quadratic"},
+    {"performRemoveAndInsert", "quadratic"},
+};
+
+// Phases known to grow faster than their intended class, as -budget overrides applied before
+// those of the command line. Drop an entry once its phase is fixed.
+const char *KnownBudgets[] = {
+    // Every load operand of an expression scans all the stores of the function, and the kill
+    // set of a block is copied for every expression added to it
+    "fillKills=cubic",
+    // The hot blocks are a vector searched once per block, and the candidates are rebuilt by
+    // set_union for every hot block
+    "fillCandidates=quadratic",
+    // A backward problem swept in function order: the need of a block moves one block up per
+    // sweep, so a ladder of diamonds takes as many sweeps as it has blocks
+    "compute_needin_needout=cubic",
+};
+
+// Smallest size of every shape; it is doubled Steps - 1 times
+unsigned getBaseSize(Shape shape) {
+    switch (shape) {
+    case Shape::LoopNest:
+        return 4;
+    case Shape::Switch:
+        return 16;
+    case Shape::Diamonds:
+        return 4;
+    case Shape::Irreducible:
+        return 16;
+    case Shape::AliasedStores:
+        return 128;
+    }
+    return 1;
+}
+
+using Clock = std::chrono::steady_clock;
+
+std::map<std::string, double> Seconds;
+std::map<std::string, Clock::time_point> Running;
+// Shapes on which the pass left invalid IR
+std::vector<std::string> Invalid;
+
+void observePhase(StringRef pass, StringRef phase, bool start) {
+    if (start) {
+        Running[phase.str()] = Clock::now();
+        return;
+    }
+    Seconds[phase.str()] +=
+        std::chrono::duration<double>(Clock::now() - Running[phase.str()]).count();
+}
+
+void runISPRE(Module &M) {
+    const PassInfo *info = PassRegistry::getPassRegistry()->getPassInfo(StringRef("ispre"));
+    legacy::PassManager PM;
+    PM.add(info->createPass());
+    PM.run(M);
+}
+
+// First lines of the verifier's report on the functions the pass left invalid, empty if every
+// function is valid
+std::string verifyOutput(Module &M) {
+    std::string report;
+    raw_string_ostream os(report);
+    for (Function &F : M) {
+        if (!F.isDeclaration()) {
+            verifyFunction(F, &os);
+        }
+    }
+    SmallVector<StringRef, 4> lines;
+    StringRef(os.str()).split(lines, '\n', 3, false);
+    lines.resize(std::min<size_t>(lines.size(), 3));
+    return join(lines, "\n");
+}
+
+unsigned countInstructions(Module &M) {
+    unsigned count = 0;
+    for (Function &F : M) {
+        count += F.getInstructionCount();
+    }
+    return count;
+}
+
+// Slope of the least squares line through (log x, log y)
+double fitExponent(const std::vector<double> &xs, const std::vector<double> &ys) {
+    double n = xs.size(), sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (size_t i = 0; i < xs.size(); i++) {
+        double x = std::log(xs[i]), y = std::log(std::max(ys[i], 1e-9));
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    return (n * sxy - sx * sy) / (n * sxx - sx * sx);
+}
+
+const ComplexityClass *findClass(StringRef name) {
+    for (const ComplexityClass &cls : Classes) {
+        if (name == cls.name) {
+            return &cls;
+        }
+    }
+    return nullptr;
+}
+
+bool applyBudget(StringRef budget) {
+    auto parts = budget.split('=');
+    auto phase = std::find_if(Phases.begin(), Phases.end(),
+                              [&](auto &entry) { return entry.first == parts.first; });
+    if (phase == Phases.end() || !findClass(parts.second)) {
+        WithColor::error() << "invalid budget '" << budget << "'\n";
+        return false;
+    }
+    phase->second = parts.second.str();
+    return true;
+}
+
+bool applyBudgets() {
+    for (StringRef budget : KnownBudgets) {
+        if (!applyBudget(budget)) {
+            return false;
+        }
+    }
+    for (StringRef budget : Budgets) {
+        if (!applyBudget(budget)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Run one shape at every size and check every phase against its class; returns the number of
+// phases that grew faster than declared. A shape on which the pass leaves invalid IR is
+// recorded in Invalid and not timed any further.
+unsigned runShape(Shape shape) {
+    std::vector<double> sizes;
+    std::map<std::string, std::vector<double>> times;
+    unsigned size = getBaseSize(shape);
+
+    for (unsigned step = 0; step < Steps; step++, size *= 2) {
+        std::map<std::string, double> best;
+        unsigned instructions = 0;
+        for (unsigned run = 0; run < Repeat; run++) {
+            LLVMContext ctx;
+            std::unique_ptr<Module> M = generateCFG(ctx, shape, size);
+            instructions = countInstructions(*M);
+            Seconds.clear();
+            runISPRE(*M);
+            std::string report = verifyOutput(*M);
+            if (!report.empty()) {
+                WithColor::error() << "ispre left invalid IR on " << getShapeName(shape)
+                                   << " at size " << size << ":\n"
+                                   << report << "\n\n";
+                Invalid.push_back(getShapeName(shape).str());
+                return 0;
+            }
+            for (auto &phase : Phases) {
+                double seconds = Seconds[phase.first];
+                best[phase.first] = run ? std::min(best[phase.first], seconds) : seconds;
+            }
+        }
+        sizes.push_back(instructions);
+        for (auto &phase : Phases) {
+            times[phase.first].push_back(best[phase.first]);
+        }
+    }
+
+    outs() << "=== " << getShapeName(shape) << " (" << (unsigned)sizes.front() << " to "
+           << (unsigned)sizes.back() << " instructions) ===\n";
+    outs() << "Phase                      First (ms)    Last (ms)  Exponent Class      Result\n";
+    unsigned failures = 0;
+    for (auto &phase : Phases) {
+        std::vector<double> &ys = times[phase.first];
+        double exponent = fitExponent(sizes, ys);
+        const ComplexityClass *cls = findClass(phase.second);
+        const char *result = "ok";
+        if (ys.back() < MinTime) {
+            result = "too fast";
+        } else if (exponent > cls->maxExponent) {
+            result = "FAIL";
+            failures++;
+        }
+        outs() << format("%-24s %12.3f %12.3f %9.2f %-10s %s\n", phase.first.c_str(),
+                         ys.front() * 1e3, ys.back() * 1e3, exponent, cls->name, result);
+    }
+    outs() << "\n";
+    return failures;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "ISPRE compile-time scaling suite\n");
+    if (!applyBudgets()) {
+        return 1;
+    }
+    if (Steps < 2) {
+        WithColor::error() << "at least two steps are needed to fit a growth curve\n";
+        return 1;
+    }
+
+    std::vector<Shape> shapes;
+    for (StringRef name : ShapeNames) {
+        Shape shape;
+        if (!parseShape(name, shape)) {
+            WithColor::error() << "unknown shape '" << name << "'\n";
+            return 1;
+        }
+        shapes.push_back(shape);
+    }
+    if (shapes.empty()) {
+        shapes.assign(std::begin(AllShapes), std::end(AllShapes));
+    }
+
+    PassRegistry &registry = *PassRegistry::getPassRegistry();
+    initializeCore(registry);
+    initializeAnalysis(registry);
+    PhaseObserver = observePhase;
+
+    unsigned failures = 0;
+    for (Shape shape : shapes) {
+        failures += runShape(shape);
+    }
+    if (!Invalid.empty()) {
+        WithColor::error() << "ispre left invalid IR on " << join(Invalid, ", ") << "\n";
+    }
+    if (failures) {
+        WithColor::error() << failures << " phase(s) grew faster than their declared class\n";
+    }
+    if (failures || !Invalid.empty()) {
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//  ispre-denylist: deny-list the speculations that did not pay off
+//
+//  Reads the counts files written by programs built with -ispre-instrument and adds every
+//  expression whose speculated value was used fewer than -min-use-ratio times per insertion
+//  to the deny list given with -o. Entries already in the deny list are kept, so the list
+//  grows over successive builds; pass it to the ISPRE passes with -ispre-deny-list.
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "DenyList.h"
+
+#include <string>
+
+using namespace llvm;
+
+static cl::list<std::string> InputFiles(cl::Positional, cl::OneOrMore,
+                                        cl::desc("<counts files of -ispre-instrument builds>"));
+
+static cl::opt<std::string> OutputFile("o", cl::Required,
+                                       cl::desc("Deny list to update (created if missing)"),
+                                       cl::value_desc("file"));
+
+static cl::opt<double> MinUseRatio("min-use-ratio",
+                                   cl::desc("Deny-list expressions whose speculated value was "
+                                            "used fewer times than this per insertion"),
+                                   cl::init(1.0));
+
+static double useRatio(const SpeculationCount &count) {
+    return count.added ? (double)count.saved / (double)count.added : 0;
+}
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "ISPRE deny list update\n");
+
+    SpeculationCounts denyList;
+    if (sys::fs::exists(OutputFile) && !readSpeculationCounts(OutputFile, denyList)) {
+        return 1;
+    }
+    size_t numKept = denyList.size();
+
+    SpeculationCounts counts;
+    for (const std::string &path : InputFiles) {
+        if (!readSpeculationCounts(path, counts)) {
+            return 1;
+        }
+    }
+    // Expressions that were never inserted cost nothing
+    for (auto &entry : counts) {
+        if (entry.second.added > 0 && useRatio(entry.second) < MinUseRatio) {
+            denyList[entry.first] = entry.second;
+        }
+    }
+
+    std::error_code EC;
+    raw_fd_ostream out(OutputFile, EC, sys::fs::OF_Text);
+    if (EC) {
+        WithColor::error() << OutputFile << ": " << EC.message() << "\n";
+        return 1;
+    }
+    out << "function\tsite\texpression\tsaved\tadded\tratio\n";
+    for (auto &entry : denyList) {
+        out << entry.first.first << "\t" << entry.first.second << "\t"
+            << entry.second.expression << "\t" << entry.second.saved
+            << "\t" << entry.second.added << "\t" << format("%.3f", useRatio(entry.second))
+            << "\n";
+    }
+    outs() << OutputFile << ": " << denyList.size() << " denied expressions ("
+           << denyList.size() - numKept << " new)\n";
+    return 0;
+}
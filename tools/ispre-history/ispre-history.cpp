@@ -0,0 +1,271 @@
+//===----------------------------------------------------------------------===//
+//
+//  ispre-history: performance history of the benchmarks and regression checks
+//
+//  `record` appends the results of an ispre-runbench JSON file to a JSON lines database,
+//  one line per benchmark and variant, keyed by git revision and keeping every sample.
+//  `compare` checks every metric recorded for two revisions with a two-sided Mann-Whitney U
+//  test and exits with an error when a metric got significantly and noticeably worse.
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <map>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace llvm;
+
+static cl::SubCommand RecordCommand("record", "Add an ispre-runbench result to the database");
+static cl::SubCommand CompareCommand("compare", "Compare two revisions of the database");
+
+static cl::opt<std::string> Database("db", cl::desc("History database (JSON lines)"),
+                                     cl::init("history.jsonl"), cl::sub(RecordCommand),
+                                     cl::sub(CompareCommand));
+
+static cl::opt<std::string> Revision("revision", cl::desc("Git revision the results belong to"),
+                                     cl::Required, cl::sub(RecordCommand));
+
+static cl::opt<std::string> Benchmark("benchmark", cl::desc("Name of the benchmark program"),
+                                      cl::Required, cl::sub(RecordCommand));
+
+static cl::opt<std::string> ResultFile(cl::Positional, cl::Required,
+                                       cl::desc("<ispre-runbench .json>"), cl::sub(RecordCommand));
+
+static cl::opt<std::string> BaseRevision(cl::Positional, cl::Required, cl::desc("<base revision>"),
+                                         cl::sub(CompareCommand));
+
+static cl::opt<std::string> NewRevision(cl::Positional, cl::Required, cl::desc("<new revision>"),
+                                        cl::sub(CompareCommand));
+
+static cl::opt<double> Alpha("alpha", cl::desc("Significance level of the test"), cl::init(0.05),
+                             cl::sub(CompareCommand));
+
+static cl::opt<double> MinChange("min-change",
+                                 cl::desc("Smallest relative change of the median reported as a "
+                                          "regression"),
+                                 cl::init(0.01), cl::sub(CompareCommand));
+
+namespace {
+// Benchmark, variant and metric
+using Key = std::tuple<std::string, std::string, std::string>;
+using Samples = std::map<Key, std::vector<double>>;
+
+double median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+}
+
+// Two-sided p-value of the Mann-Whitney U test, with the normal approximation and average
+// ranks for ties
+double mannWhitney(const std::vector<double> &a, const std::vector<double> &b) {
+    std::vector<std::pair<double, bool>> all;
+    for (double value : a) {
+        all.push_back({value, true});
+    }
+    for (double value : b) {
+        all.push_back({value, false});
+    }
+    std::sort(all.begin(), all.end());
+
+    double rankSumA = 0;
+    for (size_t i = 0; i < all.size();) {
+        size_t j = i;
+        while (j < all.size() && all[j].first == all[i].first) {
+            j++;
+        }
+        double rank = (i + 1 + j) / 2.0;
+        for (size_t k = i; k < j; k++) {
+            rankSumA += all[k].second ? rank : 0;
+        }
+        i = j;
+    }
+
+    double n1 = a.size(), n2 = b.size();
+    double u = rankSumA - n1 * (n1 + 1) / 2;
+    double sigma = std::sqrt(n1 * n2 * (n1 + n2 + 1) / 12);
+    if (sigma == 0) {
+        return 1;
+    }
+    double z = (u - n1 * n2 / 2) / sigma;
+    return std::erfc(std::fabs(z) / std::sqrt(2.0));
+}
+
+Expected<std::vector<json::Value>> readDatabase() {
+    std::vector<json::Value> records;
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(Database);
+    if (!buffer) {
+        return errorCodeToError(buffer.getError());
+    }
+    SmallVector<StringRef, 0> lines;
+    (*buffer)->getBuffer().split(lines, '\n', -1, false);
+    for (StringRef line : lines) {
+        Expected<json::Value> record = json::parse(line);
+        if (!record) {
+            return record.takeError();
+        }
+        records.push_back(std::move(*record));
+    }
+    return std::move(records);
+}
+
+// Every sample of the records whose revision starts with `revision`; text sizes are stored
+// as a single sample
+Samples collect(const std::vector<json::Value> &records, StringRef revision) {
+    Samples samples;
+    for (const json::Value &value : records) {
+        const json::Object *record = value.getAsObject();
+        if (!record || !record->getString("revision").getValueOr("").startswith(revision)) {
+            continue;
+        }
+        std::string benchmark = record->getString("benchmark").getValueOr("").str();
+        std::string variant = record->getString("variant").getValueOr("").str();
+        if (Optional<int64_t> size = record->getInteger("text_size")) {
+            samples[Key(benchmark, variant, "text_size")].push_back(*size);
+        }
+        const json::Object *metrics = record->getObject("metrics");
+        if (!metrics) {
+            continue;
+        }
+        for (const auto &metric : *metrics) {
+            const json::Array *values = metric.second.getAsArray();
+            if (!values) {
+                continue;
+            }
+            std::vector<double> &into = samples[Key(benchmark, variant, metric.first.str())];
+            for (const json::Value &sample : *values) {
+                if (Optional<double> number = sample.getAsNumber()) {
+                    into.push_back(*number);
+                }
+            }
+        }
+    }
+    return samples;
+}
+
+int record() {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFileOrSTDIN(ResultFile);
+    if (!buffer) {
+        WithColor::error() << ResultFile << ": " << buffer.getError().message() << "\n";
+        return 1;
+    }
+    Expected<json::Value> results = json::parse((*buffer)->getBuffer());
+    if (!results) {
+        WithColor::error() << ResultFile << ": " << toString(results.takeError()) << "\n";
+        return 1;
+    }
+    const json::Object *root = results->getAsObject();
+    const json::Array *binaries = root ? root->getArray("binaries") : nullptr;
+    if (!binaries) {
+        WithColor::error() << ResultFile << ": not an ispre-runbench result\n";
+        return 1;
+    }
+
+    std::error_code EC;
+    raw_fd_ostream db(Database, EC, sys::fs::OF_Append | sys::fs::OF_Text);
+    if (EC) {
+        WithColor::error() << Database << ": " << EC.message() << "\n";
+        return 1;
+    }
+    for (const json::Value &entry : *binaries) {
+        const json::Object *binary = entry.getAsObject();
+        if (!binary) {
+            continue;
+        }
+        json::Object metrics;
+        if (const json::Object *measured = binary->getObject("metrics")) {
+            for (const auto &metric : *measured) {
+                const json::Object *summary = metric.second.getAsObject();
+                if (summary && summary->getArray("samples")) {
+                    metrics[metric.first] = json::Array(*summary->getArray("samples"));
+                }
+            }
+        }
+        json::Object line{{"revision", Revision},
+                          {"benchmark", Benchmark},
+                          {"variant", binary->getString("name").getValueOr("")},
+                          {"timestamp", (int64_t)std::time(nullptr)},
+                          {"metrics", std::move(metrics)}};
+        if (Optional<int64_t> size = binary->getInteger("text_size")) {
+            line["text_size"] = *size;
+        }
+        db << json::Value(std::move(line)) << "\n";
+    }
+    return 0;
+}
+
+int compare() {
+    Expected<std::vector<json::Value>> records = readDatabase();
+    if (!records) {
+        WithColor::error() << Database << ": " << toString(records.takeError()) << "\n";
+        return 1;
+    }
+    Samples base = collect(*records, BaseRevision);
+    Samples head = collect(*records, NewRevision);
+    if (base.empty() || head.empty()) {
+        WithColor::error() << "no results recorded for "
+                           << (base.empty() ? BaseRevision : NewRevision) << "\n";
+        return 1;
+    }
+
+    outs() << "Benchmark          Variant            Metric                  Base median"
+              "    New median   Change  p-value  Result\n";
+    unsigned regressions = 0;
+    for (auto &entry : head) {
+        auto old = base.find(entry.first);
+        if (old == base.end() || old->second.empty() || entry.second.empty()) {
+            continue;
+        }
+        double before = median(old->second);
+        double after = median(entry.second);
+        double change = before != 0 ? (after - before) / before : 0;
+        // Code size is deterministic, every other metric is a distribution of runs
+        bool deterministic = std::get<2>(entry.first) == "text_size";
+        double p = deterministic ? (after != before ? 0 : 1) : mannWhitney(old->second,
+                                                                            entry.second);
+
+        // Every metric recorded is better when lower
+        const char *result = "";
+        if (p < Alpha && std::fabs(change) >= MinChange) {
+            result = change > 0 ? "REGRESSION" : "improved";
+            regressions += change > 0;
+        }
+        outs() << format("%-18s %-18s %-18s %16.6g %13.6g %+7.2f%% %8.4f  %s\n",
+                         std::get<0>(entry.first).c_str(), std::get<1>(entry.first).c_str(),
+                         std::get<2>(entry.first).c_str(), before, after, change * 100, p, result);
+    }
+    if (regressions) {
+        WithColor::error() << regressions << " significant regression(s) from " << BaseRevision
+                           << " to " << NewRevision << "\n";
+        return 1;
+    }
+    return 0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "ISPRE performance history\n");
+
+    if (RecordCommand) {
+        return record();
+    }
+    if (CompareCommand) {
+        return compare();
+    }
+    WithColor::error() << "expected a subcommand: record or compare\n";
+    return 1;
+}
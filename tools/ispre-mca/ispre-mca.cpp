@@ -0,0 +1,418 @@
+//===----------------------------------------------------------------------===//
+//
+//  ispre-mca: static throughput estimate of profiled blocks with llvm-mca
+//
+//  Lowers every variant of a program (bitcode carrying the profile, as written by opt
+//  -pgo-instr-use) to assembly with llc, cuts the assembly into the IR blocks it came from,
+//  and runs llvm-mca on every executed block for the host CPU. Each block's estimated cycles
+//  per iteration are weighted by its profile count, which gives a deterministic estimate of
+//  what speculation saved in the hot region and added on its ingress edges without running
+//  the program.
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/Bitcode/BitcodeWriter.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string> InputFiles(cl::Positional, cl::OneOrMore,
+                                        cl::desc("<variant.bc or name=variant.bc>..."));
+
+static cl::opt<std::string> CPU("mcpu", cl::desc("CPU to model (default: the host)"),
+                                cl::init("native"));
+
+static cl::opt<unsigned> Iterations("iterations", cl::desc("llvm-mca iterations of every block"),
+                                    cl::init(100));
+
+static cl::opt<unsigned> OptLevel("O", cl::desc("llc optimization level (clang links at -O0)"),
+                                  cl::init(0));
+
+static cl::opt<double> HotThreshold("threshold",
+                                    cl::desc("Blocks above this fraction of the hottest block of "
+                                             "their function are listed as hot"),
+                                    cl::init(0.9));
+
+static cl::opt<std::string> OutputFile("o", cl::desc("JSON output file"), cl::value_desc("file"),
+                                       cl::init(""));
+
+namespace {
+struct Block {
+    std::string name;
+    uint64_t count = 0;
+    bool hot = false;
+    std::vector<std::string> instructions;
+    double cyclesPerIteration = 0;
+};
+
+struct FunctionEstimate {
+    std::string name;
+    std::vector<Block> blocks;
+
+    double weightedCycles() const {
+        double total = 0;
+        for (const Block &block : blocks) {
+            total += block.count * block.cyclesPerIteration;
+        }
+        return total;
+    }
+};
+
+struct Variant {
+    std::string name;
+    std::string path;
+    std::vector<FunctionEstimate> functions;
+
+    double weightedCycles() const {
+        double total = 0;
+        for (const FunctionEstimate &function : functions) {
+            total += function.weightedCycles();
+        }
+        return total;
+    }
+};
+
+bool run(StringRef program, const std::vector<std::string> &args, StringRef stdoutFile = "") {
+    ErrorOr<std::string> path = sys::findProgramByName(program);
+    if (!path) {
+        WithColor::error() << program << ": not found\n";
+        return false;
+    }
+    std::vector<StringRef> argv = {*path};
+    argv.insert(argv.end(), args.begin(), args.end());
+    // llvm-mca warns about every call it cannot model
+    Optional<StringRef> redirects[] = {None, None, StringRef("/dev/null")};
+    if (!stdoutFile.empty()) {
+        redirects[1] = stdoutFile;
+    }
+    std::string message;
+    if (sys::ExecuteAndWait(*path, argv, None, redirects, 0, 0, &message) != 0) {
+        WithColor::error() << program << ": " << (message.empty() ? "failed" : message) << "\n";
+        return false;
+    }
+    return true;
+}
+
+// Name every block, so that llc prints the name next to the first machine block of each,
+// and record the profile count of every block of the functions that ran
+std::map<std::string, std::map<std::string, uint64_t>> getCounts(Module &M) {
+    std::map<std::string, std::map<std::string, uint64_t>> counts;
+    for (Function &F : M) {
+        if (F.isDeclaration()) {
+            continue;
+        }
+        unsigned index = 0;
+        for (BasicBlock &BB : F) {
+            if (!BB.hasName()) {
+                BB.setName("bb" + Twine(index));
+            }
+            index++;
+        }
+        Optional<Function::ProfileCount> entry = F.getEntryCount();
+        if (!entry || entry->getCount() == 0) {
+            continue;
+        }
+        DominatorTree DT(F);
+        LoopInfo LI(DT);
+        BranchProbabilityInfo BPI(F, LI);
+        BlockFrequencyInfo BFI(F, BPI, LI);
+        for (BasicBlock &BB : F) {
+            counts[F.getName().str()][BB.getName().str()] =
+                BFI.getBlockProfileCount(&BB).getValueOr(0);
+        }
+    }
+    return counts;
+}
+
+// Split llc output into the IR blocks of every function. A machine block without an IR
+// name continues the IR block before it.
+std::map<std::string, std::map<std::string, std::vector<std::string>>>
+splitAssembly(StringRef assembly) {
+    std::map<std::string, std::map<std::string, std::vector<std::string>>> blocks;
+    std::string function, block;
+    SmallVector<StringRef, 0> lines;
+    assembly.split(lines, '\n');
+    for (StringRef line : lines) {
+        if (!line.empty() && !line.startswith("\t") && !line.startswith(".") &&
+            !line.startswith("#") && line.contains(":") && line.contains("# @")) {
+            function = line.split(':').first.str();
+            block.clear();
+            continue;
+        }
+        if (function.empty()) {
+            continue;
+        }
+        if (line.startswith(".Lfunc_end")) {
+            function.clear();
+            continue;
+        }
+        if (line.startswith(".LBB") || line.startswith("# %bb.")) {
+            size_t name = line.find("# %", 1);
+            if (name != StringRef::npos) {
+                block = line.substr(name + 3).trim().str();
+            }
+            continue;
+        }
+        StringRef code = line.trim();
+        if (!block.empty() && line.startswith("\t") && !code.empty() && !code.startswith(".") &&
+            !code.startswith("#")) {
+            blocks[function][block].push_back(code.str());
+        }
+    }
+    return blocks;
+}
+
+bool estimate(Variant &variant, StringRef workDir) {
+    LLVMContext context;
+    SMDiagnostic err;
+    std::unique_ptr<Module> M = parseIRFile(variant.path, err, context);
+    if (!M) {
+        err.print(variant.path.c_str(), WithColor::error());
+        return false;
+    }
+    auto counts = getCounts(*M);
+
+    SmallString<128> prefix(workDir);
+    sys::path::append(prefix, variant.name);
+    std::string bitcode = (prefix + ".bc").str();
+    std::string assembly = (prefix + ".s").str();
+    std::string regions = (prefix + ".mca.s").str();
+    std::string report = (prefix + ".mca.json").str();
+    {
+        std::error_code EC;
+        raw_fd_ostream out(bitcode, EC);
+        if (EC) {
+            WithColor::error() << bitcode << ": " << EC.message() << "\n";
+            return false;
+        }
+        WriteBitcodeToFile(*M, out);
+    }
+    if (!run("llc", {"-O" + std::to_string(OptLevel), bitcode, "-o", assembly})) {
+        return false;
+    }
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(assembly);
+    if (!buffer) {
+        WithColor::error() << assembly << ": " << buffer.getError().message() << "\n";
+        return false;
+    }
+    auto code = splitAssembly((*buffer)->getBuffer());
+
+    // One llvm-mca region per executed block, named by its index in `estimated`
+    std::vector<Block *> estimated;
+    std::error_code EC;
+    raw_fd_ostream out(regions, EC, sys::fs::OF_Text);
+    if (EC) {
+        WithColor::error() << regions << ": " << EC.message() << "\n";
+        return false;
+    }
+    for (auto &function : counts) {
+        uint64_t hottest = 0;
+        for (auto &block : function.second) {
+            hottest = std::max(hottest, block.second);
+        }
+        FunctionEstimate result;
+        result.name = function.first;
+        for (auto &block : function.second) {
+            std::vector<std::string> &instructions = code[function.first][block.first];
+            if (block.second == 0 || instructions.empty()) {
+                continue;
+            }
+            result.blocks.push_back({block.first, block.second,
+                                     block.second > HotThreshold * hottest, instructions});
+        }
+        variant.functions.push_back(std::move(result));
+    }
+    for (FunctionEstimate &function : variant.functions) {
+        for (Block &block : function.blocks) {
+            out << "# LLVM-MCA-BEGIN " << estimated.size() << "\n";
+            for (const std::string &instruction : block.instructions) {
+                out << "\t" << instruction << "\n";
+            }
+            out << "# LLVM-MCA-END\n";
+            estimated.push_back(&block);
+        }
+    }
+    out.close();
+    if (estimated.empty()) {
+        return true;
+    }
+
+    if (!run("llvm-mca", {"-mcpu=" + CPU, "-iterations=" + std::to_string(Iterations), "-json",
+                          regions, "-o", report})) {
+        return false;
+    }
+    buffer = MemoryBuffer::getFile(report);
+    Expected<json::Value> mca = json::parse(buffer ? (*buffer)->getBuffer() : "");
+    const json::Object *root = mca ? mca->getAsObject() : nullptr;
+    const json::Array *codeRegions = root ? root->getArray("CodeRegions") : nullptr;
+    if (!codeRegions) {
+        if (!mca) {
+            consumeError(mca.takeError());
+        }
+        WithColor::error() << report << ": not an llvm-mca report\n";
+        return false;
+    }
+    for (const json::Value &entry : *codeRegions) {
+        const json::Object *region = entry.getAsObject();
+        const json::Object *summary = region ? region->getObject("SummaryView") : nullptr;
+        unsigned index;
+        if (!summary || region->getString("Name").getValueOr("").getAsInteger(10, index) ||
+            index >= estimated.size()) {
+            continue;
+        }
+        double cycles = summary->getNumber("TotalCycles").getValueOr(0);
+        double iterations = summary->getNumber("Iterations").getValueOr(1);
+        estimated[index]->cyclesPerIteration = cycles / iterations;
+    }
+    return true;
+}
+
+void print(raw_ostream &os, const std::vector<Variant> &variants) {
+    for (const Variant &variant : variants) {
+        os << "Hot blocks of " << variant.name << " (above "
+           << format("%.2f", (double)HotThreshold) << " of the hottest block)\n";
+        os << "Function                 Block                           Count  Cycles/iter"
+              "  Weighted (M)\n";
+        for (const FunctionEstimate &function : variant.functions) {
+            for (const Block &block : function.blocks) {
+                if (block.hot) {
+                    os << format("%-24s %-24s %14llu %12.2f %13.3f\n", function.name.c_str(),
+                                 block.name.c_str(), (unsigned long long)block.count,
+                                 block.cyclesPerIteration,
+                                 block.count * block.cyclesPerIteration * 1e-6);
+                }
+            }
+        }
+        os << "\n";
+    }
+
+    // Every executed block counts, so the cost of speculated insertions on cold ingress
+    // edges is charged against the hot region they relieve
+    std::map<std::string, std::vector<double>> byFunction;
+    for (size_t v = 0; v < variants.size(); v++) {
+        for (const FunctionEstimate &function : variants[v].functions) {
+            std::vector<double> &row = byFunction[function.name];
+            row.resize(variants.size(), -1);
+            row[v] = function.weightedCycles();
+        }
+    }
+    os << "Weighted cycles (M) of all executed blocks\nFunction                ";
+    for (const Variant &variant : variants) {
+        os << " " << right_justify(variant.name, 18);
+    }
+    os << "\n";
+    for (auto &function : byFunction) {
+        os << format("%-24s", function.first.c_str());
+        for (double cycles : function.second) {
+            os << " "
+               << (cycles < 0 ? right_justify("-", 18)
+                              : right_justify(formatv("{0:F3}", cycles * 1e-6).str(), 18));
+        }
+        os << "\n";
+    }
+    os << "Total                   ";
+    double base = variants.front().weightedCycles();
+    for (const Variant &variant : variants) {
+        double total = variant.weightedCycles();
+        std::string cell = formatv("{0:F3}", total * 1e-6).str();
+        if (&variant != &variants.front() && base > 0) {
+            raw_string_ostream(cell) << format(" (%+.1f%%)", 100 * (total - base) / base);
+        }
+        os << " " << right_justify(cell, 18);
+    }
+    os << "\n";
+}
+
+json::Value toJSON(const std::vector<Variant> &variants) {
+    json::Array result;
+    for (const Variant &variant : variants) {
+        json::Array functions;
+        for (const FunctionEstimate &function : variant.functions) {
+            json::Array blocks;
+            for (const Block &block : function.blocks) {
+                blocks.push_back(json::Object{{"name", block.name},
+                                              {"count", (int64_t)block.count},
+                                              {"hot", block.hot},
+                                              {"cycles_per_iteration", block.cyclesPerIteration}});
+            }
+            functions.push_back(json::Object{{"name", function.name},
+                                             {"weighted_cycles", function.weightedCycles()},
+                                             {"blocks", std::move(blocks)}});
+        }
+        result.push_back(json::Object{{"name", variant.name},
+                                      {"path", variant.path},
+                                      {"weighted_cycles", variant.weightedCycles()},
+                                      {"functions", std::move(functions)}});
+    }
+    return json::Object{{"mcpu", CPU.getValue()},
+                        {"iterations", (int64_t)Iterations},
+                        {"variants", std::move(result)}};
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "ISPRE static throughput estimate\n");
+
+    SmallString<128> workDir;
+    if (std::error_code EC = sys::fs::createUniqueDirectory("ispre-mca", workDir)) {
+        WithColor::error() << "could not create a temporary directory: " << EC.message() << "\n";
+        return 1;
+    }
+
+    std::vector<Variant> variants;
+    bool failed = false;
+    for (StringRef spec : InputFiles) {
+        auto parts = spec.split('=');
+        Variant variant;
+        variant.path = (parts.second.empty() ? spec : parts.second).str();
+        variant.name = parts.second.empty() ? sys::path::stem(spec).str() : parts.first.str();
+        if (!estimate(variant, workDir)) {
+            failed = true;
+            break;
+        }
+        variants.push_back(std::move(variant));
+    }
+    sys::fs::remove_directories(workDir);
+    if (failed) {
+        return 1;
+    }
+
+    print(outs(), variants);
+    if (!OutputFile.empty()) {
+        std::error_code EC;
+        ToolOutputFile out(OutputFile, EC, sys::fs::OF_Text);
+        if (EC) {
+            WithColor::error() << OutputFile << ": " << EC.message() << "\n";
+            return 1;
+        }
+        out.os() << formatv("{0:2}", toJSON(variants)) << "\n";
+        out.keep();
+    }
+    return 0;
+}
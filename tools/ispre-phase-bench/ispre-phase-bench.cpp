@@ -0,0 +1,171 @@
+//===----------------------------------------------------------------------===//
+//
+//  ispre-phase-bench: micro-benchmarks for the phases of the ISPRE pass
+//
+//  Builds kernels of controlled size in memory, runs the ispre pass on them and reports the
+//  time and heap allocations of each phase, per block and per expression. The kernels are the
+//  diamonds shape of ispre-cfggen: a hot loop around a ladder of diamonds whose arms compute
+//  the same expressions, with a store to one of their operands on the rarely taken arm. The
+//  pass sources are linked in directly and observed through PhaseObserver.
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/ADT/StringRef.h"
+#include "llvm/IR/Function.h"
+#include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Instructions.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/LegacyPassManager.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IR/Verifier.h"
+#include "llvm/InitializePasses.h"
+#include "llvm/Pass.h"
+#include "llvm/PassRegistry.h"
+#include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Transforms/Utils/Cloning.h"
+
+#include "CFGGen.h"
+#include "PhaseObserver.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+// Every heap allocation of the process goes through these, including the ones made by the pass
+static uint64_t NumAllocations = 0;
+
+void *operator new(std::size_t size) {
+    NumAllocations++;
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    report_bad_alloc_error("ispre-phase-bench: out of memory");
+}
+
+void *operator new[](std::size_t size) { return operator new(size); }
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+namespace {
+struct PhaseSample {
+    double seconds = 0;
+    uint64_t allocations = 0;
+};
+
+using Clock = std::chrono::steady_clock;
+
+std::map<std::string, PhaseSample> Samples;
+std::map<std::string, std::pair<Clock::time_point, uint64_t>> Running;
+
+void observePhase(StringRef pass, StringRef phase, bool start) {
+    if (start) {
+        Running[phase.str()] = std::make_pair(Clock::now(), NumAllocations);
+        return;
+    }
+    auto &begin = Running[phase.str()];
+    PhaseSample &sample = Samples[phase.str()];
+    sample.seconds += std::chrono::duration<double>(Clock::now() - begin.first).count();
+    sample.allocations += NumAllocations - begin.second;
+}
+
+// Phases reported by the ispre pass, in the order runOnFunction executes them
+const char *Phases[] = {"calculateHotColdNodes", "calculateHotColdEdges",
+                        "calculateIngressEdges", "fillXUses",
+                        "fillGens",              "fillKills",
+                        "fillCandidates",        "fillAvinAvouts",
+                        "fillRemovables",        "compute_needin_needout",
+                        "compute_inserts",       "emitMissedRemarks",
+                        "performRemoveAndInsert"};
+
+void runISPRE(Module &M) {
+    const PassInfo *info = PassRegistry::getPassRegistry()->getPassInfo(StringRef("ispre"));
+    legacy::PassManager PM;
+    PM.add(info->createPass());
+    PM.run(M);
+}
+
+void benchmarkPhase(benchmark::State &state, std::string phase) {
+    LLVMContext ctx;
+    std::unique_ptr<Module> kernel =
+        generateCFG(ctx, Shape::Diamonds, state.range(0), state.range(1));
+    unsigned blocks = 0;
+    unsigned exprs = 0;
+    for (Function &F : *kernel) {
+        blocks += F.size();
+        for (Instruction &I : instructions(F)) {
+            exprs += isa<BinaryOperator>(I);
+        }
+    }
+    uint64_t allocations = 0;
+    double seconds = 0;
+
+    PhaseObserver = observePhase;
+    bool verified = false;
+    for (auto _ : state) {
+        std::unique_ptr<Module> M = CloneModule(*kernel);
+        Samples.clear();
+        runISPRE(*M);
+        // The timings of a run that left invalid IR say nothing; every iteration runs on the
+        // same input, so checking the first is enough
+        if (!verified) {
+            if (verifyModule(*M, &errs())) {
+                state.SkipWithError("ispre left invalid IR");
+                break;
+            }
+            verified = true;
+        }
+        state.SetIterationTime(Samples[phase].seconds);
+        seconds += Samples[phase].seconds;
+        allocations += Samples[phase].allocations;
+    }
+    PhaseObserver = nullptr;
+    if (!verified) {
+        return;
+    }
+
+    double iterations = state.iterations();
+    state.counters["blocks"] = blocks;
+    state.counters["exprs"] = exprs;
+    state.counters["ns/block"] = seconds * 1e9 / iterations / blocks;
+    state.counters["ns/expr"] = seconds * 1e9 / iterations / exprs;
+    state.counters["allocs/block"] = allocations / iterations / blocks;
+    state.counters["allocs/expr"] = allocations / iterations / exprs;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    PassRegistry &registry = *PassRegistry::getPassRegistry();
+    initializeCore(registry);
+    initializeAnalysis(registry);
+
+    for (const char *phase : Phases) {
+        benchmark::RegisterBenchmark(phase, benchmarkPhase, std::string(phase))
+            ->ArgNames({"diamonds", "exprs"})
+            ->ArgsProduct({{4, 8, 16}, {2, 8}})
+            ->UseManualTime()
+            // Every iteration runs the whole pass, so a short phase must not pick the count
+            ->Iterations(10)
+            ->Unit(benchmark::kMicrosecond);
+    }
+
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
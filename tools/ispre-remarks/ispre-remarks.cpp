@@ -0,0 +1,315 @@
+//===----------------------------------------------------------------------===//
+//
+//  ispre-remarks: rank ISPRE outcomes by estimated dynamic savings
+//
+//  Reads the YAML remark files written by -pass-remarks-output or
+//  -fsave-optimization-record, keeps the remarks of the ispre passes, joins them with the
+//  entry and block counts of the profile-annotated module and aggregates them by function and
+//  source line. Missed remarks are aggregated by function and site.
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Analysis/BlockFrequencyInfo.h"
+#include "llvm/Analysis/BranchProbabilityInfo.h"
+#include "llvm/Analysis/LoopInfo.h"
+#include "llvm/IR/Dominators.h"
+#include "llvm/IR/LLVMContext.h"
+#include "llvm/IR/Module.h"
+#include "llvm/IRReader/IRReader.h"
+#include "llvm/Remarks/Remark.h"
+#include "llvm/Remarks/RemarkParser.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/SourceMgr.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+
+static cl::list<std::string> InputFiles(cl::Positional, cl::OneOrMore,
+                                        cl::desc("<remark files (.yaml)>"));
+
+// The entry count of an IR PGO profile is not its first counter; the counters sit on the
+// edges of a spanning tree, so the counts are read from a module opt has annotated
+static cl::opt<std::string>
+    ProfiledModule("profiled-ir",
+                   cl::desc("Module annotated with the build's profile (e.g. by -pgo-instr-use)"),
+                   cl::value_desc("file"));
+
+// Matched exactly: a prefix would also pull in -ispre-stale-profile and the other helpers
+static cl::list<std::string>
+    PassNames("passes",
+              cl::desc("Only read remarks of these passes (default: ispre,ispre2,ispre3,ispre4)"),
+              cl::value_desc("pass,..."), cl::CommaSeparated);
+
+static cl::opt<unsigned> TopN("top", cl::desc("Number of rows in each ranking"), cl::init(20));
+
+namespace {
+// Outcome of all ISPRE remarks attributed to one source line
+struct SiteStats {
+    uint64_t removed = 0;
+    uint64_t added = 0;
+    unsigned numRemoved = 0;
+    unsigned numSpeculated = 0;
+
+    int64_t net() const { return (int64_t)removed - (int64_t)added; }
+};
+
+// Missed remarks of one expression, by the site key of the pass (<pass>:<block>:<index>).
+// Bands and repeated runs report a site several times; it keeps its highest use count and
+// every reason it was blocked for.
+struct MissedSite {
+    std::string function;
+    std::string location;
+    std::set<std::string> reasons;
+    std::string expression;
+    uint64_t count = 0;
+};
+
+struct FunctionProfile {
+    uint64_t entryCount = 0;
+    // Sum of the block counts, against which the net savings are put as %Prof
+    uint64_t totalCount = 0;
+};
+
+std::map<std::pair<std::string, std::string>, SiteStats> sites;
+std::map<std::string, SiteStats> functions;
+std::map<std::pair<std::string, std::string>, MissedSite> missed;
+std::map<std::string, FunctionProfile> profiles;
+} // namespace
+
+static std::string getLocation(const remarks::Remark &remark) {
+    if (!remark.Loc) {
+        return "<unknown>";
+    }
+    return (remark.Loc->SourceFilePath + ":" + Twine(remark.Loc->SourceLine)).str();
+}
+
+static StringRef getArg(const remarks::Remark &remark, StringRef key) {
+    for (const remarks::Argument &arg : remark.Args) {
+        if (arg.Key == key) {
+            return arg.Val;
+        }
+    }
+    return "";
+}
+
+static uint64_t getCountArg(const remarks::Remark &remark, StringRef key) {
+    uint64_t count = 0;
+    getArg(remark, key).getAsInteger(10, count);
+    return count;
+}
+
+static void addRemark(const remarks::Remark &remark) {
+    static const std::vector<std::string> cascade{"ispre", "ispre2", "ispre3", "ispre4"};
+    const std::vector<std::string> &passes = PassNames.empty() ? cascade : PassNames;
+    if (std::find(passes.begin(), passes.end(), remark.PassName) == passes.end()) {
+        return;
+    }
+
+    std::string function = remark.FunctionName.str();
+    std::string location = getLocation(remark);
+    SiteStats &site = sites[std::make_pair(function, location)];
+    SiteStats &total = functions[function];
+
+    if (remark.RemarkType == remarks::Type::Passed && remark.RemarkName == "Removed") {
+        uint64_t count = getCountArg(remark, "BlockCount");
+        site.removed += count;
+        site.numRemoved++;
+        total.removed += count;
+        total.numRemoved++;
+    } else if (remark.RemarkType == remarks::Type::Passed && remark.RemarkName == "Speculated") {
+        // The clone runs at the terminator of the edge's source, so every execution of the
+        // source block pays for it, not only those that take the ingress edge
+        uint64_t count = getCountArg(remark, "SourceCount");
+        site.added += count;
+        site.numSpeculated++;
+        total.added += count;
+        total.numSpeculated++;
+    } else if (remark.RemarkType == remarks::Type::Missed) {
+        // Function-level remarks (NoProfile, ColdFunction, ...) have no site of their own
+        StringRef siteKey = getArg(remark, "Site");
+        MissedSite &site =
+            missed[std::make_pair(function, siteKey.empty() ? location : siteKey.str())];
+        site.function = function;
+        site.location = location;
+        site.reasons.insert(remark.RemarkName.str());
+        site.expression = getArg(remark, "Expression").str();
+        site.count = std::max(site.count, getCountArg(remark, "BlockCount"));
+    }
+}
+
+static Error readRemarkFile(StringRef path) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFile(path);
+    if (!buffer) {
+        return errorCodeToError(buffer.getError());
+    }
+
+    Expected<std::unique_ptr<remarks::RemarkParser>> parser =
+        remarks::createRemarkParserFromMeta(remarks::Format::YAML, (*buffer)->getBuffer());
+    if (!parser) {
+        return parser.takeError();
+    }
+
+    while (true) {
+        Expected<std::unique_ptr<remarks::Remark>> remark = (*parser)->next();
+        if (!remark) {
+            Error err = remark.takeError();
+            if (err.isA<remarks::EndOfFileError>()) {
+                consumeError(std::move(err));
+                return Error::success();
+            }
+            return err;
+        }
+        addRemark(**remark);
+    }
+}
+
+static Error readProfiledModule(StringRef path) {
+    LLVMContext context;
+    SMDiagnostic diag;
+    std::unique_ptr<Module> M = parseIRFile(path, diag, context);
+    if (!M) {
+        return createStringError(inconvertibleErrorCode(), diag.getMessage());
+    }
+
+    for (Function &F : *M) {
+        Optional<Function::ProfileCount> entry = F.getEntryCount();
+        if (F.isDeclaration() || !entry) {
+            continue;
+        }
+        FunctionProfile &profile = profiles[F.getName().str()];
+        profile.entryCount += entry->getCount();
+        DominatorTree DT(F);
+        LoopInfo LI(DT);
+        BranchProbabilityInfo BPI(F, LI);
+        BlockFrequencyInfo BFI(F, BPI, LI);
+        for (BasicBlock &BB : F) {
+            profile.totalCount += BFI.getBlockProfileCount(&BB).getValueOr(0);
+        }
+    }
+    return Error::success();
+}
+
+static void printSites(raw_ostream &os) {
+    std::vector<std::pair<std::pair<std::string, std::string>, SiteStats>> ranked(sites.begin(),
+                                                                                 sites.end());
+    ranked.erase(std::remove_if(ranked.begin(), ranked.end(),
+                                [](auto &entry) {
+                                    return entry.second.numRemoved == 0 &&
+                                           entry.second.numSpeculated == 0;
+                                }),
+                 ranked.end());
+    std::stable_sort(ranked.begin(), ranked.end(), [](auto &a, auto &b) {
+        return a.second.net() > b.second.net();
+    });
+
+    os << "=== Speculation by source line (ranked by estimated net dynamic savings) ===\n";
+    os << "           Net        Removed          Added  Function @ Location\n";
+    unsigned rows = 0;
+    for (auto &entry : ranked) {
+        if (rows++ == TopN) {
+            break;
+        }
+        os << format("%14lld %14llu %14llu  ", (long long)entry.second.net(),
+                     (unsigned long long)entry.second.removed,
+                     (unsigned long long)entry.second.added)
+           << entry.first.first << " @ " << entry.first.second << "\n";
+    }
+    os << "\n";
+}
+
+static void printFunctions(raw_ostream &os) {
+    std::vector<std::pair<std::string, SiteStats>> ranked(functions.begin(), functions.end());
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](auto &a, auto &b) { return a.second.net() > b.second.net(); });
+
+    os << "=== Speculation by function ===\n";
+    os << "           Net        Removed          Added #Removed    #Spec     EntryCount    %Prof"
+          "  Function\n";
+    unsigned rows = 0;
+    for (auto &entry : ranked) {
+        if (rows++ == TopN) {
+            break;
+        }
+        os << format("%14lld %14llu %14llu %8u %8u ", (long long)entry.second.net(),
+                     (unsigned long long)entry.second.removed,
+                     (unsigned long long)entry.second.added, entry.second.numRemoved,
+                     entry.second.numSpeculated);
+        auto profile = profiles.find(entry.first);
+        if (profile != profiles.end() && profile->second.totalCount != 0) {
+            double share = 100.0 * entry.second.net() / profile->second.totalCount;
+            os << format("%14llu %7.2f%%", (unsigned long long)profile->second.entryCount, share);
+        } else {
+            os << "              -        -";
+        }
+        os << "  " << entry.first << "\n";
+    }
+    os << "\n";
+}
+
+static void printMissed(raw_ostream &os) {
+    std::vector<MissedSite> ranked;
+    for (auto &entry : missed) {
+        ranked.push_back(entry.second);
+    }
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [](const MissedSite &a, const MissedSite &b) { return a.count > b.count; });
+
+    os << "=== Biggest missed opportunities (ranked by use count) ===\n";
+    os << "         Count Reason              Function @ Location: Expression\n";
+    unsigned rows = 0;
+    for (const MissedSite &site : ranked) {
+        if (rows++ == TopN) {
+            break;
+        }
+        std::string reasons;
+        for (const std::string &reason : site.reasons) {
+            reasons += (reasons.empty() ? "" : ",") + reason;
+        }
+        os << format("%14llu %-18s  ", (unsigned long long)site.count, reasons.c_str())
+           << site.function << " @ " << site.location << ": " << site.expression << "\n";
+    }
+}
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "ISPRE remark aggregation\n");
+
+    for (const std::string &path : InputFiles) {
+        if (Error err = readRemarkFile(path)) {
+            WithColor::error() << path << ": " << toString(std::move(err)) << "\n";
+            return 1;
+        }
+    }
+    if (!ProfiledModule.empty()) {
+        if (Error err = readProfiledModule(ProfiledModule)) {
+            WithColor::error() << ProfiledModule << ": " << toString(std::move(err)) << "\n";
+            return 1;
+        }
+    }
+
+    uint64_t removed = 0;
+    uint64_t added = 0;
+    for (auto &entry : functions) {
+        removed += entry.second.removed;
+        added += entry.second.added;
+    }
+    outs() << "Estimated dynamic expressions removed:            " << removed << "\n";
+    outs() << "Estimated dynamic expressions speculatively added: " << added << "\n";
+    outs() << "Estimated net savings:                            "
+           << (int64_t)removed - (int64_t)added << "\n\n";
+
+    printSites(outs());
+    printFunctions(outs());
+    printMissed(outs());
+    return 0;
+}
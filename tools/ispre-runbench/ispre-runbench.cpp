@@ -0,0 +1,401 @@
+//===----------------------------------------------------------------------===//
+//
+//  ispre-runbench: repeated, pinned runtime measurements of benchmark binaries
+//
+//  Runs every binary (or command, such as an opt invocation whose compile time is wanted) a
+//  number of times after warm-up runs, pinned to one CPU, and records the wall time of each
+//  run together with hardware counters read through perf_event_open. Reports the median of
+//  every metric with a distribution-free 95% confidence interval, and the size of the .text
+//  section of every binary. The results are written as JSON and the table is rendered from
+//  that JSON, so `-render` can print it again from a saved file.
+//
+////===----------------------------------------------------------------------===//
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/CommandLine.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Format.h"
+#include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/InitLLVM.h"
+#include "llvm/Support/JSON.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/WithColor.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sched.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace llvm;
+
+static cl::list<std::string> Binaries(cl::Positional, cl::ZeroOrMore,
+                                      cl::desc("<binary, name=binary or name='command args'>..."));
+
+static cl::opt<unsigned> Warmup("warmup", cl::desc("Unmeasured runs before the measured ones"),
+                                cl::init(3));
+
+static cl::opt<unsigned> Runs("runs", cl::desc("Measured runs of every binary"), cl::init(15));
+
+static cl::opt<int> CPU("cpu", cl::desc("CPU to pin the runs to (-1 to not pin)"), cl::init(0));
+
+static cl::opt<std::string> OutputFile("o", cl::desc("JSON output file"), cl::value_desc("file"),
+                                       cl::init("-"));
+
+static cl::opt<std::string> Baseline("baseline",
+                                     cl::desc("Name of the binary the others are compared to"),
+                                     cl::value_desc("name"));
+
+static cl::opt<std::string> RenderFile("render",
+                                       cl::desc("Print the table of a saved JSON file and exit"),
+                                       cl::value_desc("file"));
+
+namespace {
+struct Counter {
+    const char *name;
+    uint32_t type;
+    uint64_t config;
+};
+
+const Counter Counters[] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"l1i_misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1I | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+};
+
+constexpr unsigned NumCounters = sizeof(Counters) / sizeof(Counters[0]);
+
+struct Sample {
+    double seconds;
+    // -1 when the counter could not be opened (no PMU, or perf_event_paranoid too high)
+    double counts[NumCounters];
+};
+
+int openCounter(const Counter &counter, pid_t pid) {
+    perf_event_attr attr = {};
+    attr.size = sizeof(attr);
+    attr.type = counter.type;
+    attr.config = counter.config;
+    attr.disabled = 1;
+    attr.enable_on_exec = 1;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return syscall(SYS_perf_event_open, &attr, pid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+// Value of a counter, scaled up when the kernel had to multiplex it
+double readCounter(int fd) {
+    uint64_t values[3];
+    if (fd < 0 || read(fd, values, sizeof(values)) != sizeof(values) || values[2] == 0) {
+        return -1;
+    }
+    return (double)values[0] * values[1] / values[2];
+}
+
+// Run `command` once with its output discarded; returns false if it could not be run or failed
+bool runOnce(const std::vector<std::string> &command, Sample &sample) {
+    int ready[2];
+    if (pipe(ready) != 0) {
+        return false;
+    }
+    std::vector<char *> args;
+    for (const std::string &arg : command) {
+        args.push_back(const_cast<char *>(arg.c_str()));
+    }
+    args.push_back(nullptr);
+    pid_t pid = fork();
+    if (pid < 0) {
+        return false;
+    }
+    if (pid == 0) {
+        // Wait until the parent has attached the counters, which start counting at exec
+        close(ready[1]);
+        char go;
+        if (read(ready[0], &go, 1) != 1) {
+            _exit(127);
+        }
+        int devnull = open("/dev/null", O_RDWR);
+        dup2(devnull, STDIN_FILENO);
+        dup2(devnull, STDOUT_FILENO);
+        execvp(args[0], args.data());
+        _exit(127);
+    }
+
+    close(ready[0]);
+    int fds[NumCounters];
+    for (unsigned c = 0; c < NumCounters; c++) {
+        fds[c] = openCounter(Counters[c], pid);
+    }
+    auto start = std::chrono::steady_clock::now();
+    bool started = write(ready[1], "x", 1) == 1;
+    close(ready[1]);
+    int status = 0;
+    waitpid(pid, &status, 0);
+    sample.seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (unsigned c = 0; c < NumCounters; c++) {
+        sample.counts[c] = readCounter(fds[c]);
+        if (fds[c] >= 0) {
+            close(fds[c]);
+        }
+    }
+    return started && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+int64_t getTextSize(StringRef path) {
+    Expected<object::OwningBinary<object::ObjectFile>> binary =
+        object::ObjectFile::createObjectFile(path);
+    if (!binary) {
+        consumeError(binary.takeError());
+        return -1;
+    }
+    for (const object::SectionRef &section : binary->getBinary()->sections()) {
+        Expected<StringRef> name = section.getName();
+        if (name && *name == ".text") {
+            return section.getSize();
+        }
+        if (!name) {
+            consumeError(name.takeError());
+        }
+    }
+    return -1;
+}
+
+// Median and a distribution-free 95% confidence interval for it: the order statistics at
+// ranks n/2 -+ 1.96 * sqrt(n) / 2 of the sorted samples
+json::Object summarize(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    double median = n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+    double halfWidth = 1.96 * std::sqrt((double)n) / 2;
+    size_t low = (size_t)std::max(0.0, std::floor(n / 2.0 - halfWidth));
+    size_t high = (size_t)std::min(n - 1.0, std::ceil(n / 2.0 + halfWidth) - 1);
+
+    double mean = 0;
+    for (double value : values) {
+        mean += value;
+    }
+    mean /= n;
+    double variance = 0;
+    for (double value : values) {
+        variance += (value - mean) * (value - mean);
+    }
+    double stddev = n > 1 ? std::sqrt(variance / (n - 1)) : 0;
+
+    return json::Object{{"median", median},
+                        {"ci_low", values[low]},
+                        {"ci_high", values[high]},
+                        {"mean", mean},
+                        {"stddev", stddev},
+                        {"samples", json::Array(values)}};
+}
+
+// Measure one binary or command; returns null if any run failed
+json::Value measure(StringRef spec) {
+    // The text before the first '=' is a name only if it cannot be part of a path or of the
+    // arguments, so that "./prog --level=3" and "/tmp/a=b/prog" are run as given
+    auto parts = spec.split('=');
+    bool named = !parts.second.empty() && !parts.first.empty() &&
+                 parts.first.find_first_of(" /") == StringRef::npos;
+    StringRef path = named ? parts.second : spec;
+    SmallVector<StringRef, 8> words;
+    path.split(words, ' ', -1, false);
+    std::vector<std::string> command(words.begin(), words.end());
+    StringRef name = named ? parts.first : sys::path::filename(command[0]);
+
+    Sample sample;
+    for (unsigned run = 0; run < Warmup; run++) {
+        if (!runOnce(command, sample)) {
+            WithColor::error() << path << ": failed to run\n";
+            return nullptr;
+        }
+    }
+    std::vector<Sample> samples;
+    for (unsigned run = 0; run < Runs; run++) {
+        if (!runOnce(command, sample)) {
+            WithColor::error() << path << ": failed to run\n";
+            return nullptr;
+        }
+        samples.push_back(sample);
+    }
+
+    json::Object metrics;
+    std::vector<double> seconds;
+    for (const Sample &s : samples) {
+        seconds.push_back(s.seconds);
+    }
+    metrics["seconds"] = summarize(seconds);
+    for (unsigned c = 0; c < NumCounters; c++) {
+        std::vector<double> counts;
+        for (const Sample &s : samples) {
+            counts.push_back(s.counts[c]);
+        }
+        bool available = std::all_of(counts.begin(), counts.end(), [](double v) { return v >= 0; });
+        metrics[Counters[c].name] = available ? json::Value(summarize(counts)) : nullptr;
+    }
+
+    // Only programs given by path are sized, so tools found on PATH (such as opt, when
+    // compile time is measured) do not report their own size
+    int64_t textSize = StringRef(command[0]).contains('/') ? getTextSize(command[0]) : -1;
+    return json::Object{{"name", name.str()},
+                        {"path", path},
+                        {"text_size", textSize >= 0 ? json::Value(textSize) : nullptr},
+                        {"runs", (int64_t)Runs},
+                        {"metrics", std::move(metrics)}};
+}
+
+void renderMetric(raw_ostream &os, const json::Object *metrics, StringRef key, double scale,
+                  const char *fmt) {
+    const json::Object *metric = metrics ? metrics->getObject(key) : nullptr;
+    if (!metric) {
+        os << right_justify("-", 32);
+        return;
+    }
+    std::string cell;
+    raw_string_ostream cellOS(cell);
+    cellOS << format(fmt, *metric->getNumber("median") * scale) << " ["
+           << format(fmt, *metric->getNumber("ci_low") * scale) << ", "
+           << format(fmt, *metric->getNumber("ci_high") * scale) << "]";
+    os << right_justify(cellOS.str(), 32);
+}
+
+void render(raw_ostream &os, const json::Value &results) {
+    const json::Object *root = results.getAsObject();
+    const json::Array *binaries = root ? root->getArray("binaries") : nullptr;
+    if (!binaries) {
+        WithColor::error() << "not an ispre-runbench result\n";
+        return;
+    }
+    // Median time of the baseline, when one was named
+    Optional<double> baseline;
+    StringRef baselineName = root->getString("baseline").getValueOr("");
+    for (const json::Value &entry : *binaries) {
+        const json::Object *binary = entry.getAsObject();
+        const json::Object *metrics = binary ? binary->getObject("metrics") : nullptr;
+        const json::Object *seconds = metrics ? metrics->getObject("seconds") : nullptr;
+        if (seconds && binary->getString("name") == baselineName) {
+            baseline = seconds->getNumber("median");
+        }
+    }
+    os << "Median [95% CI] over " << root->getInteger("runs").getValueOr(0)
+       << " runs, pinned to CPU " << root->getInteger("cpu").getValueOr(-1) << "\n";
+    os << "Binary                    .text                       Time (ms)"
+          "                      Cycles (M)                Instructions (M)"
+          "               Branch misses (K)                  L1i misses (K)";
+    if (baseline) {
+        os << right_justify("Time change", 24);
+    }
+    os << "\n";
+    for (const json::Value &entry : *binaries) {
+        const json::Object *binary = entry.getAsObject();
+        if (!binary) {
+            continue;
+        }
+        const json::Object *metrics = binary->getObject("metrics");
+        os << format("%-20s ", binary->getString("name").getValueOr("?").str().c_str());
+        if (Optional<int64_t> size = binary->getInteger("text_size")) {
+            os << format("%10lld", (long long)*size);
+        } else {
+            os << right_justify("-", 10);
+        }
+        renderMetric(os, metrics, "seconds", 1e3, "%.2f");
+        renderMetric(os, metrics, "cycles", 1e-6, "%.2f");
+        renderMetric(os, metrics, "instructions", 1e-6, "%.2f");
+        renderMetric(os, metrics, "branch_misses", 1e-3, "%.1f");
+        renderMetric(os, metrics, "l1i_misses", 1e-3, "%.1f");
+        const json::Object *seconds = metrics ? metrics->getObject("seconds") : nullptr;
+        if (baseline && *baseline > 0 && seconds) {
+            double change = *seconds->getNumber("median") / *baseline - 1;
+            std::string cell;
+            raw_string_ostream cellOS(cell);
+            cellOS << format("%+.1f%% vs ", change * 100) << baselineName;
+            os << right_justify(cellOS.str(), 24);
+        }
+        os << "\n";
+    }
+}
+
+int renderFile(StringRef path) {
+    ErrorOr<std::unique_ptr<MemoryBuffer>> buffer = MemoryBuffer::getFileOrSTDIN(path);
+    if (!buffer) {
+        WithColor::error() << path << ": " << buffer.getError().message() << "\n";
+        return 1;
+    }
+    Expected<json::Value> results = json::parse((*buffer)->getBuffer());
+    if (!results) {
+        WithColor::error() << path << ": " << toString(results.takeError()) << "\n";
+        return 1;
+    }
+    render(outs(), *results);
+    return 0;
+}
+} // namespace
+
+int main(int argc, char **argv) {
+    InitLLVM X(argc, argv);
+    cl::ParseCommandLineOptions(argc, argv, "ISPRE benchmark runner\n");
+
+    if (!RenderFile.empty()) {
+        return renderFile(RenderFile);
+    }
+    if (Binaries.empty() || Runs == 0) {
+        WithColor::error() << "nothing to run\n";
+        return 1;
+    }
+
+    if (CPU >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(CPU, &set);
+        // Inherited by every child
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            WithColor::warning() << "could not pin to CPU " << CPU << "\n";
+        }
+    }
+
+    json::Array binaries;
+    for (StringRef spec : Binaries) {
+        json::Value result = measure(spec);
+        if (result.kind() == json::Value::Null) {
+            return 1;
+        }
+        binaries.push_back(std::move(result));
+    }
+    json::Value results = json::Object{{"runs", (int64_t)Runs},
+                                       {"warmup", (int64_t)Warmup},
+                                       {"cpu", (int64_t)CPU},
+                                       {"baseline", Baseline.getValue()},
+                                       {"binaries", std::move(binaries)}};
+
+    std::error_code EC;
+    ToolOutputFile out(OutputFile, EC, sys::fs::OF_Text);
+    if (EC) {
+        WithColor::error() << OutputFile << ": " << EC.message() << "\n";
+        return 1;
+    }
+    out.os() << formatv("{0:2}", results) << "\n";
+    out.keep();
+
+    // The table always goes to stderr when the JSON goes to stdout
+    render(OutputFile == "-" ? errs() : outs(), results);
+    return 0;
+}